@@ -0,0 +1,288 @@
+#pragma once
+
+#include "Qt5Compat.h"
+
+#include <QAbstractItemModel>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/// Read-only tree of grouped aggregates, e.g. region → site → device with count(*) and avg(value) per group.
+///
+/// Every level of the tree groups the rows by one more expression, column 0 shows the group value and the other
+/// columns the aggregates. select() only groups the top level, the children of a node are grouped by DuckDB when the
+/// view expands it (fetchMore()). The query for the children of a node groups the children of all its siblings too,
+/// so expanding a sibling afterwards needs no query. Fetched children are kept until the next select().
+class QDuckDBAggregateTreeModel : public QAbstractItemModel {
+public:
+	explicit QDuckDBAggregateTreeModel(QObject *parent = nullptr, const QSqlDatabase &db = QSqlDatabase())
+	    : QAbstractItemModel(parent), m_db(db.isValid() ? db : QSqlDatabase::database()) {}
+
+	/// groups the rows of table by levels, one SQL expression per level of the tree, and computes the aggregates for
+	/// every group, e.g. setQuery("readings", {"region", "site", "device"}, {"count(*)", "avg(value)"}).
+	/// Selects the top level.
+	bool setQuery(const QString &table, const QStringList &levels, const QStringList &aggregates) {
+		m_table = table;
+		m_levels = levels;
+		m_aggregates = aggregates;
+		return select();
+	}
+	QString tableName() const { return m_table; }
+	QStringList levels() const { return m_levels; }
+	QStringList aggregates() const { return m_aggregates; }
+
+	/// aggregates only the rows matching the SQL condition, its placeholders are bound to values. Selects again.
+	bool setFilter(const QString &condition, const QVariantList &values = QVariantList()) {
+		m_filter = condition;
+		m_filterValues = values;
+		return select();
+	}
+	QString filter() const { return m_filter; }
+
+	/// groups the top level again and drops all fetched children
+	bool select() {
+		beginResetModel();
+		m_root = std::make_unique<Node>();
+		m_lastError = QSqlError();
+		std::vector<std::unique_ptr<Node>> children;
+		const bool ok = !m_table.isEmpty() && !m_levels.isEmpty() && groupTopLevel(children);
+		if (ok)
+			adopt(m_root.get(), children);
+		endResetModel();
+		return ok;
+	}
+
+	QSqlError lastError() const { return m_lastError; }
+
+	/// group values from the top level down to index
+	QVariantList groupPath(const QModelIndex &index) const { return path(nodeFor(index)); }
+
+	QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override {
+		const Node *node = nodeFor(parent);
+		if (row < 0 || column < 0 || column >= columnCount() || parent.column() > 0 ||
+		    static_cast<size_t>(row) >= node->children.size())
+			return QModelIndex();
+		return createIndex(row, column, node->children[static_cast<size_t>(row)].get());
+	}
+
+	QModelIndex parent(const QModelIndex &child) const override {
+		if (!child.isValid())
+			return QModelIndex();
+		const Node *parent = static_cast<const Node *>(child.internalPointer())->parent;
+		if (!parent || parent == m_root.get())
+			return QModelIndex();
+		return createIndex(parent->row, 0, const_cast<Node *>(parent));
+	}
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+		if (parent.column() > 0)
+			return 0;
+		return static_cast<int>(nodeFor(parent)->children.size());
+	}
+
+	int columnCount(const QModelIndex & = QModelIndex()) const override {
+		return 1 + static_cast<int>(m_aggregates.size());
+	}
+
+	bool hasChildren(const QModelIndex &parent = QModelIndex()) const override {
+		if (parent.column() > 0)
+			return false;
+		const Node *node = nodeFor(parent);
+		if (node == m_root.get())
+			return !node->children.empty();
+		return hasLevelBelow(node) && (!node->fetched || !node->children.empty());
+	}
+
+	bool canFetchMore(const QModelIndex &parent) const override {
+		if (!parent.isValid() || parent.column() > 0)
+			return false;
+		const Node *node = nodeFor(parent);
+		return hasLevelBelow(node) && !node->fetched;
+	}
+
+	void fetchMore(const QModelIndex &parent) override {
+		if (canFetchMore(parent))
+			fetchChildren(const_cast<Node *>(nodeFor(parent)));
+	}
+
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+		if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole))
+			return QVariant();
+		const Node *node = nodeFor(index);
+		return index.column() == 0 ? node->key : node->values.value(index.column() - 1);
+	}
+
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override {
+		if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+			if (section == 0)
+				return m_levels.join(QStringLiteral(" / "));
+			if (section > 0 && section <= m_aggregates.size())
+				return m_aggregates.at(section - 1);
+		}
+		return QAbstractItemModel::headerData(section, orientation, role);
+	}
+
+protected:
+	struct Node {
+		Node *parent = nullptr;
+		int row = 0;
+		// index of the level the node groups by, -1 for the invisible root
+		int depth = -1;
+		bool fetched = false;
+		QVariant key;
+		QVariantList values;
+		std::vector<std::unique_ptr<Node>> children;
+	};
+
+	const Node *nodeFor(const QModelIndex &index) const {
+		return index.isValid() ? static_cast<const Node *>(index.internalPointer()) : m_root.get();
+	}
+
+	bool hasLevelBelow(const Node *node) const { return node->depth + 1 < m_levels.size(); }
+
+	static QVariantList path(const Node *node) {
+		QVariantList values;
+		for (; node && node->depth >= 0; node = node->parent)
+			values.prepend(node->key);
+		return values;
+	}
+
+	QSqlDatabase database() const { return m_db; }
+
+private:
+	// groups the children of node and of its siblings which were not fetched yet
+	void fetchChildren(Node *node) {
+		Node *parent = node->parent;
+		bool othersFetched = true;
+		for (const auto &sibling : parent->children)
+			othersFetched = othersFetched && (sibling.get() == node || sibling->fetched);
+
+		QSqlQuery query(m_db);
+		query.setForwardOnly(true);
+		if (!groupBy(query, path(parent), 2, othersFetched ? node : nullptr))
+			return;
+
+		// rows are ordered by the group value of the siblings, like the siblings themselves
+		std::vector<std::vector<std::unique_ptr<Node>>> children(parent->children.size());
+		size_t current = 0;
+		while (query.next()) {
+			const QVariant key = query.value(0);
+			size_t match = current;
+			while (match < parent->children.size() && !(parent->children[match]->key == key))
+				++match;
+			if (match == parent->children.size())
+				continue;
+			current = match;
+			children[current].push_back(newNode(query, 1));
+		}
+		if (query.lastError().isValid()) {
+			m_lastError = query.lastError();
+			return;
+		}
+		for (size_t i = 0; i < children.size(); ++i) {
+			Node *sibling = parent->children[i].get();
+			if (sibling->fetched)
+				continue;
+			if (children[i].empty()) {
+				sibling->fetched = true;
+				continue;
+			}
+			beginInsertRows(createIndex(sibling->row, 0, sibling), 0, static_cast<int>(children[i].size()) - 1);
+			adopt(sibling, children[i]);
+			endInsertRows();
+		}
+	}
+
+	bool groupTopLevel(std::vector<std::unique_ptr<Node>> &children) {
+		QSqlQuery query(m_db);
+		query.setForwardOnly(true);
+		if (!groupBy(query, QVariantList(), 1, nullptr))
+			return false;
+		while (query.next())
+			children.push_back(newNode(query, 0));
+		if (query.lastError().isValid()) {
+			m_lastError = query.lastError();
+			return false;
+		}
+		return true;
+	}
+
+	// groups the rows within the groups of prefix by the next levels, of the group of only if it is set
+	bool groupBy(QSqlQuery &query, const QVariantList &prefix, int levels, const Node *only) {
+		QStringList conditions;
+		QVariantList params;
+		if (!m_filter.isEmpty()) {
+			conditions.append(QLatin1Char('(') + m_filter + QLatin1Char(')'));
+			params = m_filterValues;
+		}
+		for (int i = 0; i < prefix.size(); ++i) {
+			conditions.append(QStringLiteral("(%1) IS NOT DISTINCT FROM ?").arg(m_levels.at(i)));
+			params.append(prefix.at(i));
+		}
+		if (only) {
+			conditions.append(QStringLiteral("(%1) IS NOT DISTINCT FROM ?").arg(m_levels.at(only->depth)));
+			params.append(only->key);
+		}
+		QStringList columns;
+		QStringList groups;
+		QStringList order;
+		for (int i = 0; i < levels; ++i) {
+			columns.append(QLatin1Char('(') + m_levels.at(static_cast<int>(prefix.size()) + i) + QLatin1Char(')'));
+			groups.append(QString::number(i + 1));
+			order.append(QString::number(i + 1) + QStringLiteral(" ASC NULLS LAST"));
+		}
+		columns.append(m_aggregates);
+		QString sql = QStringLiteral("SELECT ") + columns.join(QStringLiteral(", ")) + QStringLiteral(" FROM ") +
+		              m_db.driver()->escapeIdentifier(m_table, QSqlDriver::TableName);
+		if (!conditions.isEmpty())
+			sql += QStringLiteral(" WHERE ") + conditions.join(QStringLiteral(" AND "));
+		sql += QStringLiteral(" GROUP BY ") + groups.join(QStringLiteral(", ")) + QStringLiteral(" ORDER BY ") +
+		       order.join(QStringLiteral(", "));
+		if (!query.prepare(sql)) {
+			m_lastError = query.lastError();
+			return false;
+		}
+		for (const auto &param : qtAsConst(params))
+			query.addBindValue(param);
+		if (!query.exec()) {
+			m_lastError = query.lastError();
+			return false;
+		}
+		return true;
+	}
+
+	// node of the group in column keyColumn of the current row, followed by the aggregates
+	std::unique_ptr<Node> newNode(const QSqlQuery &query, int keyColumn) const {
+		auto node = std::make_unique<Node>();
+		node->key = query.value(keyColumn);
+		node->values.reserve(m_aggregates.size());
+		for (int i = 0; i < m_aggregates.size(); ++i)
+			node->values.append(query.value(keyColumn + 1 + i));
+		return node;
+	}
+
+	void adopt(Node *parent, std::vector<std::unique_ptr<Node>> &children) {
+		parent->fetched = true;
+		parent->children = std::move(children);
+		for (size_t i = 0; i < parent->children.size(); ++i) {
+			parent->children[i]->parent = parent;
+			parent->children[i]->row = static_cast<int>(i);
+			parent->children[i]->depth = parent->depth + 1;
+		}
+	}
+
+	QSqlDatabase m_db;
+	QString m_table;
+	QStringList m_levels;
+	QStringList m_aggregates;
+	QString m_filter;
+	QVariantList m_filterValues;
+	std::unique_ptr<Node> m_root = std::make_unique<Node>();
+	QSqlError m_lastError;
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <QMetaObject>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QSqlResult>
+#include <QVariant>
+#include <cstdint>
+
+// Arrow C data and stream interfaces, see https://arrow.apache.org/docs/format/CStreamInterface.html.
+// The guards are the ones of the specification, so Arrow, nanoarrow or DuckDB headers may be included as well.
+extern "C" {
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+	const char *format;
+	const char *name;
+	const char *metadata;
+	int64_t flags;
+	int64_t n_children;
+	struct ArrowSchema **children;
+	struct ArrowSchema *dictionary;
+	void (*release)(struct ArrowSchema *);
+	void *private_data;
+};
+
+struct ArrowArray {
+	int64_t length;
+	int64_t null_count;
+	int64_t offset;
+	int64_t n_buffers;
+	int64_t n_children;
+	const void **buffers;
+	struct ArrowArray **children;
+	struct ArrowArray *dictionary;
+	void (*release)(struct ArrowArray *);
+	void *private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+#ifndef ARROW_C_STREAM_INTERFACE
+#define ARROW_C_STREAM_INTERFACE
+
+struct ArrowArrayStream {
+	int (*get_schema)(struct ArrowArrayStream *, struct ArrowSchema *out);
+	int (*get_next)(struct ArrowArrayStream *, struct ArrowArray *out);
+	const char *(*get_last_error)(struct ArrowArrayStream *);
+	void (*release)(struct ArrowArrayStream *);
+	void *private_data;
+};
+
+#endif // ARROW_C_STREAM_INTERFACE
+}
+
+/// Columnar exchange of results and tables through the Arrow C stream interface, without QVariant conversions.
+///
+/// An exported stream is converted from DuckDB's result chunks batch by batch. It can be imported by Arrow
+/// (arrow::ImportRecordBatchReader), nanoarrow or pyarrow (pyarrow.RecordBatchReader._import_from_c).
+/// The caller owns the stream and calls its release callback when done. The rows are streamed from the connection,
+/// consume or release the stream before executing the next statement on it. Otherwise the next batch fails with EIO.
+/// In the other direction, streams of any producer can be queried as a view or ingested into a table.
+namespace QDuckDBArrow {
+
+/// executes sql with the positional params on db and moves its result into out.
+/// Returns false on errors, see db.lastError().
+inline bool exportQuery(const QSqlDatabase &db, const QString &sql, const QVariantList &params,
+                        ArrowArrayStream *out) {
+	bool ok = false;
+	if (!out || !db.isOpen())
+		return false;
+	if (!QMetaObject::invokeMethod(db.driver(), "exportArrowStream", Qt::DirectConnection, Q_RETURN_ARG(bool, ok),
+	                               Q_ARG(QString, sql), Q_ARG(QVariantList, params),
+	                               Q_ARG(void *, static_cast<void *>(out))))
+		return false;
+	return ok;
+}
+
+inline bool exportQuery(const QSqlDatabase &db, const QString &sql, ArrowArrayStream *out) {
+	return exportQuery(db, sql, QVariantList(), out);
+}
+
+/// executes the prepared statement of query with its bound values and moves the result into out.
+/// Prepare and bind query without exec(), rows already fetched by query are not affected.
+/// Returns false on errors, see query.driver()->lastError().
+inline bool exportQuery(const QSqlQuery &query, ArrowArrayStream *out) {
+	QSqlDriver *driver = const_cast<QSqlDriver *>(query.driver());
+	bool ok = false;
+	if (!out || !driver || !driver->isOpen() || !query.result())
+		return false;
+	if (!QMetaObject::invokeMethod(driver, "exportResultArrowStream", Qt::DirectConnection, Q_RETURN_ARG(bool, ok),
+	                               Q_ARG(void *, const_cast<QSqlResult *>(query.result())),
+	                               Q_ARG(void *, static_cast<void *>(out))))
+		return false;
+	return ok;
+}
+
+/// registers stream as the temporary view name on the connection of db, e.g. for "INSERT INTO t SELECT * FROM name"
+/// or any other query. DuckDB scans the Arrow buffers in place. The driver takes the stream over if registration
+/// succeeds and releases it in unregisterStream() or when db is closed. A stream can only be read once, so can the
+/// view. Returns false on errors, see db.lastError().
+inline bool registerStream(const QSqlDatabase &db, const QString &name, ArrowArrayStream *stream) {
+	bool ok = false;
+	if (!stream || !db.isOpen())
+		return false;
+	if (!QMetaObject::invokeMethod(db.driver(), "registerArrowStream", Qt::DirectConnection, Q_RETURN_ARG(bool, ok),
+	                               Q_ARG(QString, name), Q_ARG(void *, static_cast<void *>(stream))))
+		return false;
+	return ok;
+}
+
+/// drops the view of registerStream() and releases its stream
+inline bool unregisterStream(const QSqlDatabase &db, const QString &name) {
+	bool ok = false;
+	if (!db.isOpen())
+		return false;
+	if (!QMetaObject::invokeMethod(db.driver(), "unregisterArrowStream", Qt::DirectConnection,
+	                               Q_RETURN_ARG(bool, ok), Q_ARG(QString, name)))
+		return false;
+	return ok;
+}
+
+enum class IngestMode {
+	/// inserts the rows into an existing table, the columns are matched by position
+	Append,
+	/// creates the table with the columns of the stream
+	Create,
+};
+
+/// inserts all rows of stream into table with one statement, without converting them row by row.
+/// The stream is released. Returns the number of rows, -1 on errors, see db.lastError().
+inline qlonglong ingest(const QSqlDatabase &db, const QString &table, ArrowArrayStream *stream,
+                        IngestMode mode = IngestMode::Append) {
+	qlonglong rows = -1;
+	if (!stream || !db.isOpen())
+		return -1;
+	if (!QMetaObject::invokeMethod(db.driver(), "ingestArrowStream", Qt::DirectConnection,
+	                               Q_RETURN_ARG(qlonglong, rows), Q_ARG(QString, table),
+	                               Q_ARG(void *, static_cast<void *>(stream)),
+	                               Q_ARG(bool, mode == IngestMode::Create)))
+		return -1;
+	return rows;
+}
+
+} // namespace QDuckDBArrow
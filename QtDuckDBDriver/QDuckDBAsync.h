@@ -0,0 +1,124 @@
+#pragma once
+
+#include <QFuture>
+#include <QFutureInterface>
+#include <QMetaObject>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QThreadPool>
+#include <QVariant>
+#include <atomic>
+#include <functional>
+
+/// Fully fetched result of a statement executed by QDuckDBAsync::exec
+struct QDuckDBAsyncResult {
+	/// set if the statement could not be prepared, executed or fetched
+	QSqlError error;
+	/// columns of the result set, empty if the statement has none
+	QSqlRecord record;
+	QList<QVariantList> rows;
+	int numRowsAffected = -1;
+};
+
+namespace QDuckDBAsync {
+
+namespace detail {
+
+inline QString nextConnectionName() {
+	static std::atomic<int> counter {0};
+	return QStringLiteral("qt_duckdb_async_%1").arg(counter.fetch_add(1));
+}
+
+inline bool hasSharedInstance(const QSqlDatabase &db) {
+	for (const auto &option : db.connectOptions().split(u';')) {
+		if (option.trimmed().compare(QLatin1String("SHARED_INSTANCE"), Qt::CaseInsensitive) == 0)
+			return true;
+	}
+	return false;
+}
+
+inline QFuture<QDuckDBAsyncResult> finishedWithError(const QSqlError &error) {
+	QFutureInterface<QDuckDBAsyncResult> promise;
+	promise.reportStarted();
+	QDuckDBAsyncResult result;
+	result.error = error;
+	promise.reportResult(result);
+	promise.reportFinished();
+	return promise.future();
+}
+
+} // namespace detail
+
+/// Executes sql with the positional params on a thread of QThreadPool::globalInstance().
+///
+/// The statement runs on its own connection to the DuckDB instance of db, so db has to be opened with the
+/// SHARED_INSTANCE connection option. Changes of an open transaction on db are not visible to it, neither are the
+/// TEMP tables and views of db, including the views of registerArrowStream(), registerModel() and registerColumns(),
+/// nor the buffers of registerBuffer(). Query them through db instead, or keep the data in tables of the database.
+/// Watch the returned future with a QFutureWatcher to receive the result in the calling thread.
+/// Cancelling the future from any thread interrupts the running statement: the worker executes it task by task and
+/// checks the future between two tasks, without an event loop or a further thread.
+inline QFuture<QDuckDBAsyncResult> exec(const QSqlDatabase &db, const QString &sql,
+                                        const QVariantList &params = QVariantList()) {
+	if (!db.isOpen())
+		return detail::finishedWithError(QSqlError(QStringLiteral("Unable to execute statement"),
+		                                           QStringLiteral("Database is not open"),
+		                                           QSqlError::ConnectionError));
+	if (!detail::hasSharedInstance(db))
+		return detail::finishedWithError(
+		    QSqlError(QStringLiteral("Unable to execute statement"),
+		              QStringLiteral("Asynchronous execution requires the SHARED_INSTANCE connection option"),
+		              QSqlError::ConnectionError));
+
+	QFutureInterface<QDuckDBAsyncResult> promise;
+	promise.reportStarted();
+	QFuture<QDuckDBAsyncResult> future = promise.future();
+
+	const QString sourceName = db.connectionName();
+	QThreadPool::globalInstance()->start([promise, sourceName, sql, params]() mutable {
+		QDuckDBAsyncResult result;
+		const QString name = detail::nextConnectionName();
+		{
+			QSqlDatabase clone = QSqlDatabase::cloneDatabase(sourceName, name);
+			if (!promise.isCanceled() && !clone.open())
+				result.error = clone.lastError();
+			if (clone.isOpen()) {
+				std::function<bool()> isCanceled = [promise]() { return promise.isCanceled(); };
+				QMetaObject::invokeMethod(clone.driver(), "setInterruptCheck", Qt::DirectConnection,
+				                          Q_ARG(void *, &isCanceled));
+				if (!promise.isCanceled()) {
+					QSqlQuery query(clone);
+					query.setForwardOnly(true);
+					bool ok = query.prepare(sql);
+					for (const QVariant &param : params)
+						query.addBindValue(param);
+					if (ok && query.exec()) {
+						result.record = query.record();
+						result.numRowsAffected = query.numRowsAffected();
+						const int columns = result.record.count();
+						while (query.next() && !promise.isCanceled()) {
+							QVariantList row;
+							row.reserve(columns);
+							for (int i = 0; i < columns; ++i)
+								row.append(query.value(i));
+							result.rows.append(row);
+						}
+					}
+					if (query.lastError().isValid())
+						result.error = query.lastError();
+				}
+			}
+		}
+		QSqlDatabase::removeDatabase(name);
+
+		// results of a cancelled future are discarded
+		promise.reportResult(result);
+		promise.reportFinished();
+	});
+	return future;
+}
+
+} // namespace QDuckDBAsync
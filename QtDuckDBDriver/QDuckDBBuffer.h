@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMetaObject>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QString>
+
+/// In-memory files for DuckDB's readers, e.g. a Parquet or CSV document received from a socket, without writing it
+/// to a temporary file. Qt resources need no registration, they are readable as ":/data/x.csv" or "qrc:/data/x.csv".
+///
+///     QDuckDBBuffer::registerBuffer(db, "incoming.parquet", socket->readAll());
+///     query.exec("SELECT * FROM read_parquet('" + QDuckDBBuffer::path("incoming.parquet") + "')");
+namespace QDuckDBBuffer {
+
+/// path of the buffer name in queries
+inline QString path(const QString &name) {
+	return QStringLiteral("qtbuffer://") + name;
+}
+
+/// makes data readable as path(name) by the queries of the connection of db. data is shared, not copied.
+/// Returns false on errors, see db.lastError().
+inline bool registerBuffer(const QSqlDatabase &db, const QString &name, const QByteArray &data) {
+	bool ok = false;
+	if (!db.isOpen())
+		return false;
+	if (!QMetaObject::invokeMethod(db.driver(), "registerBuffer", Qt::DirectConnection, Q_RETURN_ARG(bool, ok),
+	                               Q_ARG(QString, name), Q_ARG(QByteArray, data)))
+		return false;
+	return ok;
+}
+
+/// removes the buffer name, readers which opened it keep their copy
+inline bool unregisterBuffer(const QSqlDatabase &db, const QString &name) {
+	bool ok = false;
+	if (!db.isOpen())
+		return false;
+	if (!QMetaObject::invokeMethod(db.driver(), "unregisterBuffer", Qt::DirectConnection, Q_RETURN_ARG(bool, ok),
+	                               Q_ARG(QString, name)))
+		return false;
+	return ok;
+}
+
+} // namespace QDuckDBBuffer
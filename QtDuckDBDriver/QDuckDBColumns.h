@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QBitArray>
+#include <QMetaObject>
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QSqlResult>
+#include <QStringList>
+#include <QVector>
+
+/// one column of a result fetched with QDuckDBColumns::fetch()
+struct QDuckDBColumn {
+	enum Type {
+		/// BOOLEAN and integers up to UINTEGER, in integers
+		Integer,
+		/// FLOAT, DOUBLE and DECIMAL, in reals. With the numerical precision policy QSql::LowPrecisionInt32 or
+		/// QSql::LowPrecisionInt64 of the query they are rounded to integers instead, like the values of next().
+		Real,
+		/// all other types converted to VARCHAR, in texts, e.g. UBIGINT and HUGEINT which are kept exact.
+		/// Also DECIMAL with QSql::HighPrecision, exact like the values of next().
+		Text,
+	};
+
+	QString name;
+	Type type = Text;
+	QVector<qint64> integers;
+	QVector<double> reals;
+	QStringList texts;
+	/// false for NULL values, which are 0 or an empty string in the values
+	QBitArray valid;
+
+	qsizetype size() const { return valid.size(); }
+};
+
+/// Columnar fetch of results for analytics code, e.g. to compute on whole columns or to fill a chart series.
+/// The values are copied chunk by chunk from DuckDB's vectors without a QVariant per value, numeric columns close to
+/// memcpy speed.
+///
+///     QSqlQuery query(db);
+///     query.setForwardOnly(true);
+///     query.exec("SELECT ts, value FROM readings WHERE sensor = 7");
+///     QVector<QDuckDBColumn> columns;
+///     if (QDuckDBColumns::fetch(query, columns))
+///         plot(columns[0].integers, columns[1].reals);
+namespace QDuckDBColumns {
+
+/// moves the rows of the executed query which next() did not return yet into columns, one per result column.
+/// The query is positioned after the last row afterwards. Returns false on errors, see query.driver()->lastError().
+inline bool fetch(QSqlQuery &query, QVector<QDuckDBColumn> &columns) {
+	QSqlDriver *driver = const_cast<QSqlDriver *>(query.driver());
+	bool ok = false;
+	if (!driver || !driver->isOpen() || !query.result())
+		return false;
+	if (!QMetaObject::invokeMethod(driver, "fetchColumns", Qt::DirectConnection, Q_RETURN_ARG(bool, ok),
+	                               Q_ARG(void *, const_cast<QSqlResult *>(query.result())),
+	                               Q_ARG(void *, static_cast<void *>(&columns))))
+		return false;
+	return ok;
+}
+
+} // namespace QDuckDBColumns
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QIODevice>
+#include <QMetaObject>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QVariant>
+
+/// Export of query results to a QIODevice (file, socket, QBuffer, ...) in a format DuckDB encodes itself, at the
+/// speed of COPY and without a temporary file or converting the values to QVariant.
+///
+///     QFile file("report.parquet");
+///     file.open(QIODevice::WriteOnly);
+///     QDuckDBExport::toDevice(db, "SELECT * FROM measurements", &file, QDuckDBExport::Format::Parquet);
+///
+/// The device is written on the calling thread while DuckDB encodes the rows, DuckDB waits while the device falls
+/// behind. The call returns when the export finished, so it blocks an event loop running on that thread, e.g. the
+/// one of a GUI. Export from a worker thread with its own connection (QSqlDatabase::cloneDatabase()) and a device
+/// it owns, e.g. a QTcpSocket created there. Connect to the queryProgress() signal of the driver for the progress
+/// of the statement.
+namespace QDuckDBExport {
+
+enum class Format {
+	Csv,
+	/// newline-delimited JSON, needs the json extension
+	Json,
+	/// needs the parquet extension
+	Parquet,
+};
+
+inline QString formatName(Format format) {
+	switch (format) {
+	case Format::Json:
+		return QStringLiteral("json");
+	case Format::Parquet:
+		return QStringLiteral("parquet");
+	case Format::Csv:
+		break;
+	}
+	return QStringLiteral("csv");
+}
+
+/// writes the result of sql with the positional params to device. options are further options of COPY, e.g.
+/// "HEADER false, DELIMITER ';'" or "COMPRESSION zstd". They become part of the SQL of the statement, never pass
+/// untrusted text. Returns the number of bytes written, -1 on errors, see db.lastError().
+inline qlonglong toDevice(const QSqlDatabase &db, const QString &sql, const QVariantList &params, QIODevice *device,
+                          Format format = Format::Csv, const QString &options = QString()) {
+	qlonglong bytes = -1;
+	if (!device || !db.isOpen())
+		return -1;
+	if (!QMetaObject::invokeMethod(db.driver(), "exportToDevice", Qt::DirectConnection, Q_RETURN_ARG(qlonglong, bytes),
+	                               Q_ARG(QString, sql), Q_ARG(QVariantList, params), Q_ARG(QObject *, device),
+	                               Q_ARG(QString, formatName(format)), Q_ARG(QString, options)))
+		return -1;
+	return bytes;
+}
+
+inline qlonglong toDevice(const QSqlDatabase &db, const QString &sql, QIODevice *device, Format format = Format::Csv,
+                          const QString &options = QString()) {
+	return toDevice(db, sql, QVariantList(), device, format, options);
+}
+
+/// writes the result of the last query prepared or executed by query, with its bound values, to device.
+/// Returns the number of bytes written, -1 on errors, see query.driver()->lastError().
+inline qlonglong toDevice(const QSqlQuery &query, QIODevice *device, Format format = Format::Csv,
+                          const QString &options = QString()) {
+	QVariantList params;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+	params = query.boundValues();
+#else
+	const int count = query.boundValues().size();
+	for (int i = 0; i < count; ++i)
+		params.append(query.boundValue(i));
+#endif
+	QSqlDriver *driver = const_cast<QSqlDriver *>(query.driver());
+	qlonglong bytes = -1;
+	if (!device || !driver || !driver->isOpen() ||
+	    !QMetaObject::invokeMethod(driver, "exportToDevice", Qt::DirectConnection, Q_RETURN_ARG(qlonglong, bytes),
+	                               Q_ARG(QString, query.lastQuery()), Q_ARG(QVariantList, params),
+	                               Q_ARG(QObject *, device), Q_ARG(QString, formatName(format)),
+	                               Q_ARG(QString, options)))
+		return -1;
+	return bytes;
+}
+
+} // namespace QDuckDBExport
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <QMetaObject>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QStringList>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+/// C++ functions callable from SQL, registered on the database instance of a connection. They are vectorized:
+/// every call gets the values of up to 2048 rows as arrays of the argument types instead of one QVariant per value.
+/// DuckDB calls them from its worker threads, in parallel for large inputs, so they must be thread-safe.
+///
+///     QDuckDBFunction::registerScalar<double, double>(db, "fahrenheit",
+///         [](qsizetype rows, double *result, const double *celsius) {
+///             for (qsizetype i = 0; i < rows; ++i)
+///                 result[i] = celsius[i] * 9 / 5 + 32;
+///         });
+///
+/// Arguments and results are BOOLEAN (bool), TINYINT to BIGINT and UTINYINT to UBIGINT ((u)int8_t to (u)int64_t),
+/// FLOAT or DOUBLE. Rows with a NULL argument are NULL for scalar functions and skipped by aggregates.
+struct QDuckDBFunctionDefinition {
+	enum Kind { Scalar, Aggregate };
+
+	Kind kind = Scalar;
+	QString name;
+	/// DuckDB type names of the arguments and the result
+	QStringList argumentTypes;
+	QString returnType;
+
+	/// scalar functions: computes the results of rows rows from one array per argument
+	std::function<void(qsizetype rows, const void *const *arguments, void *result)> scalar;
+
+	/// aggregates: creates the state of a group, adds rows rows to it, merges another state into it, writes its
+	/// result and deletes it
+	std::function<void *()> create;
+	std::function<void(void *state, qsizetype rows, const void *const *arguments)> update;
+	std::function<void(void *state, const void *other)> combine;
+	std::function<void(const void *state, void *result)> finalize;
+	std::function<void(void *state)> destroy;
+};
+
+namespace QDuckDBFunction {
+
+/// DuckDB type name of the C++ type T
+template <typename T>
+QString typeName() {
+	static_assert(std::is_arithmetic_v<T> && sizeof(T) <= 8, "Only fixed-width numbers and bool are supported");
+	if constexpr (std::is_same_v<T, bool>)
+		return QStringLiteral("BOOLEAN");
+	else if constexpr (std::is_floating_point_v<T>)
+		return sizeof(T) == 4 ? QStringLiteral("FLOAT") : QStringLiteral("DOUBLE");
+	else if constexpr (std::is_signed_v<T>)
+		return sizeof(T) == 1   ? QStringLiteral("TINYINT")
+		       : sizeof(T) == 2 ? QStringLiteral("SMALLINT")
+		       : sizeof(T) == 4 ? QStringLiteral("INTEGER")
+		                        : QStringLiteral("BIGINT");
+	else
+		return sizeof(T) == 1   ? QStringLiteral("UTINYINT")
+		       : sizeof(T) == 2 ? QStringLiteral("USMALLINT")
+		       : sizeof(T) == 4 ? QStringLiteral("UINTEGER")
+		                        : QStringLiteral("UBIGINT");
+}
+
+namespace detail {
+template <typename R, typename... Args, typename F, size_t... I>
+void callScalar(const F &function, qsizetype rows, const void *const *arguments, void *result,
+                std::index_sequence<I...>) {
+	function(rows, static_cast<R *>(result), static_cast<const Args *>(arguments[I])...);
+}
+
+template <typename State, typename... Args, typename F, size_t... I>
+void callUpdate(const F &update, void *state, qsizetype rows, const void *const *arguments, std::index_sequence<I...>) {
+	update(*static_cast<State *>(state), rows, static_cast<const Args *>(arguments[I])...);
+}
+} // namespace detail
+
+/// registers definition on the instance of db. Returns false on errors, see db.lastError().
+inline bool registerFunction(const QSqlDatabase &db, QDuckDBFunctionDefinition &definition) {
+	bool ok = false;
+	if (!db.isOpen())
+		return false;
+	if (!QMetaObject::invokeMethod(db.driver(), "registerFunction", Qt::DirectConnection, Q_RETURN_ARG(bool, ok),
+	                               Q_ARG(void *, static_cast<void *>(&definition))))
+		return false;
+	return ok;
+}
+
+/// registers function(qsizetype rows, R *result, const Args *...arguments) as the scalar function name(Args...)
+template <typename R, typename... Args, typename F>
+bool registerScalar(const QSqlDatabase &db, const QString &name, F function) {
+	QDuckDBFunctionDefinition definition;
+	definition.kind = QDuckDBFunctionDefinition::Scalar;
+	definition.name = name;
+	definition.argumentTypes = QStringList {typeName<Args>()...};
+	definition.returnType = typeName<R>();
+	definition.scalar = [function](qsizetype rows, const void *const *arguments, void *result) {
+		detail::callScalar<R, Args...>(function, rows, arguments, result, std::index_sequence_for<Args...>());
+	};
+	return registerFunction(db, definition);
+}
+
+/// registers the aggregate name(Args...) with a State per group, e.g. for a weighted average:
+///
+///     struct Weighted { double sum = 0; double weights = 0; };
+///     QDuckDBFunction::registerAggregate<Weighted, double, double, double>(db, "weighted_avg",
+///         [](Weighted &s, qsizetype rows, const double *value, const double *weight) { ... },
+///         [](Weighted &s, const Weighted &other) { s.sum += other.sum; s.weights += other.weights; },
+///         [](const Weighted &s) { return s.sum / s.weights; });
+template <typename State, typename R, typename... Args, typename Update, typename Combine, typename Finalize>
+bool registerAggregate(const QSqlDatabase &db, const QString &name, Update update, Combine combine,
+                       Finalize finalize) {
+	QDuckDBFunctionDefinition definition;
+	definition.kind = QDuckDBFunctionDefinition::Aggregate;
+	definition.name = name;
+	definition.argumentTypes = QStringList {typeName<Args>()...};
+	definition.returnType = typeName<R>();
+	definition.create = [] { return static_cast<void *>(new State()); };
+	definition.destroy = [](void *state) { delete static_cast<State *>(state); };
+	definition.update = [update](void *state, qsizetype rows, const void *const *arguments) {
+		detail::callUpdate<State, Args...>(update, state, rows, arguments, std::index_sequence_for<Args...>());
+	};
+	definition.combine = [combine](void *state, const void *other) {
+		combine(*static_cast<State *>(state), *static_cast<const State *>(other));
+	};
+	definition.finalize = [finalize](const void *state, void *result) {
+		*static_cast<R *>(result) = finalize(*static_cast<const State *>(state));
+	};
+	return registerFunction(db, definition);
+}
+
+} // namespace QDuckDBFunction
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "QDuckDBAsync.h"
+#include <QFuture>
+#include <QMetaObject>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QSqlResult>
+#include <QVariant>
+
+/// Row counts of queries without fetching their rows, e.g. to size the scroll bar of a model immediately.
+namespace QDuckDBRowCount {
+
+/// estimated number of rows of sql from the cardinality estimate of its plan, -1 if there is none.
+/// The estimate is computed without executing sql and may be far off for selective filters.
+inline qlonglong estimate(const QSqlDatabase &db, const QString &sql, const QVariantList &params = QVariantList()) {
+	qlonglong rows = -1;
+	if (!db.isOpen())
+		return rows;
+	if (!QMetaObject::invokeMethod(db.driver(), "estimateRowCount", Qt::DirectConnection, Q_RETURN_ARG(qlonglong, rows),
+	                               Q_ARG(QString, sql), Q_ARG(QVariantList, params)))
+		return -1;
+	return rows;
+}
+
+/// estimated number of rows of the statement prepared or executed by query, e.g. of QSqlQueryModel::query().
+/// The estimate comes from the plan the result of query already holds, nothing is planned again.
+inline qlonglong estimate(const QSqlQuery &query) {
+	QSqlDriver *driver = const_cast<QSqlDriver *>(query.driver());
+	qlonglong rows = -1;
+	if (!driver || !driver->isOpen() || !query.result() ||
+	    !QMetaObject::invokeMethod(driver, "estimateResultRowCount", Qt::DirectConnection,
+	                               Q_RETURN_ARG(qlonglong, rows),
+	                               Q_ARG(void *, const_cast<QSqlResult *>(query.result()))))
+		return -1;
+	return rows;
+}
+
+/// counts the rows of sql on a thread of the global QThreadPool, see QDuckDBAsync::exec.
+/// The count is the first value of the only row of the result.
+inline QFuture<QDuckDBAsyncResult> exact(const QSqlDatabase &db, const QString &sql,
+                                         const QVariantList &params = QVariantList()) {
+	return QDuckDBAsync::exec(db, QStringLiteral("SELECT count(*) FROM (") + sql + QStringLiteral(")"), params);
+}
+
+} // namespace QDuckDBRowCount
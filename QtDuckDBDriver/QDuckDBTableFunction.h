@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QAbstractItemModel>
+#include <QMetaObject>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QVariant>
+#include <cstdint>
+#include <type_traits>
+
+/// In-process data as views of the connection, e.g. to join a table against the rows of a model without creating a
+/// temporary table first. The views are backed by the table function qt_source(), which only reads the columns a query
+/// references. Arrays are scanned in place, models are copied before each execution.
+namespace QDuckDBTableFunction {
+
+/// registers model as the temporary view name on the connection of db.
+/// Models are not thread-safe, so DuckDB's threads never read them: right before each execution of a statement using
+/// the view, the rows are fetched completely and the columns it references are copied. Statements must be prepared
+/// and executed on the thread of model, on other threads they fail. Returns false on errors, see db.lastError().
+inline bool registerModel(const QSqlDatabase &db, const QString &name, QAbstractItemModel *model) {
+	bool ok = false;
+	if (!model || !db.isOpen())
+		return false;
+	if (!QMetaObject::invokeMethod(db.driver(), "registerModel", Qt::DirectConnection, Q_RETURN_ARG(bool, ok),
+	                               Q_ARG(QString, name), Q_ARG(QObject *, model)))
+		return false;
+	return ok;
+}
+
+/// fixed-width members of an array of structs, e.g. of a QVector<Sample>:
+///
+///     QDuckDBTableFunction::Columns columns(samples.size());
+///     columns.add("time", &samples[0].time, sizeof(Sample)).add("value", &samples[0].value, sizeof(Sample));
+class Columns {
+public:
+	explicit Columns(qsizetype rows) : m_rows(rows) {}
+
+	/// adds a column of rows values starting at first, stride bytes apart
+	template <typename T>
+	Columns &add(const QString &name, const T *first, qsizetype stride = sizeof(T)) {
+		QVariantMap column;
+		column.insert(QStringLiteral("name"), name);
+		column.insert(QStringLiteral("type"), typeName<T>());
+		const auto address = static_cast<qulonglong>(reinterpret_cast<uintptr_t>(first));
+		column.insert(QStringLiteral("data"), QVariant::fromValue(address));
+		column.insert(QStringLiteral("stride"), QVariant::fromValue(static_cast<qlonglong>(stride)));
+		m_columns.append(column);
+		return *this;
+	}
+
+	qsizetype rows() const { return m_rows; }
+	QVariantList columns() const { return m_columns; }
+
+private:
+	template <typename T>
+	static QString typeName() {
+		static_assert(std::is_arithmetic_v<T> && sizeof(T) <= 8, "Only fixed-width numbers and bool can be scanned");
+		if constexpr (std::is_same_v<T, bool>)
+			return QStringLiteral("BOOLEAN");
+		else if constexpr (std::is_floating_point_v<T>)
+			return sizeof(T) == 4 ? QStringLiteral("FLOAT") : QStringLiteral("DOUBLE");
+		else if constexpr (std::is_signed_v<T>)
+			return sizeof(T) == 1   ? QStringLiteral("TINYINT")
+			       : sizeof(T) == 2 ? QStringLiteral("SMALLINT")
+			       : sizeof(T) == 4 ? QStringLiteral("INTEGER")
+			                        : QStringLiteral("BIGINT");
+		else
+			return sizeof(T) == 1   ? QStringLiteral("UTINYINT")
+			       : sizeof(T) == 2 ? QStringLiteral("USMALLINT")
+			       : sizeof(T) == 4 ? QStringLiteral("UINTEGER")
+			                        : QStringLiteral("UBIGINT");
+	}
+
+	qsizetype m_rows;
+	QVariantList m_columns;
+};
+
+/// registers the columns as the temporary view name on the connection of db. Contiguous columns are scanned in place,
+/// the memory must stay valid until unregister(). Returns false on errors, see db.lastError().
+inline bool registerColumns(const QSqlDatabase &db, const QString &name, const Columns &columns) {
+	bool ok = false;
+	if (!db.isOpen())
+		return false;
+	if (!QMetaObject::invokeMethod(db.driver(), "registerColumns", Qt::DirectConnection, Q_RETURN_ARG(bool, ok),
+	                               Q_ARG(QString, name), Q_ARG(qlonglong, static_cast<qlonglong>(columns.rows())),
+	                               Q_ARG(QVariantList, columns.columns())))
+		return false;
+	return ok;
+}
+
+/// drops the view of registerModel() or registerColumns()
+inline bool unregister(const QSqlDatabase &db, const QString &name) {
+	bool ok = false;
+	if (!db.isOpen())
+		return false;
+	if (!QMetaObject::invokeMethod(db.driver(), "unregisterSource", Qt::DirectConnection, Q_RETURN_ARG(bool, ok),
+	                               Q_ARG(QString, name)))
+		return false;
+	return ok;
+}
+
+} // namespace QDuckDBTableFunction
@@ -0,0 +1,765 @@
+#pragma once
+
+#include "QDuckDBAsync.h"
+#include "QDuckDBRowCount.h"
+#include "Qt5Compat.h"
+#include <QAbstractTableModel>
+#include <QCache>
+#include <QFutureWatcher>
+#include <QMap>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlField>
+#include <QSqlIndex>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QStringList>
+#include <QTimer>
+#include <QVariant>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <utility>
+
+/// Read-only table model which only fetches the rows that are accessed.
+///
+/// Rows are fetched in pages of pageSize() rows, ordered by the key columns (the primary key of the table, or its
+/// rowid). A page next to an already fetched page is located by its key (keyset pagination), other pages are located
+/// once with OFFSET. At most cachedPages() converted pages are kept in a least recently used cache, so the memory of
+/// the model does not grow with the table and every row is reachable with at most one query.
+///
+/// sort() and the filters are executed by DuckDB, enable sorting on the view to sort by a clicked header.
+/// The model does not watch the table, call select() or refresh() after it changed.
+class QDuckDBTableModel : public QAbstractTableModel {
+public:
+	explicit QDuckDBTableModel(QObject *parent = nullptr, const QSqlDatabase &db = QSqlDatabase())
+	    : QAbstractTableModel(parent), m_db(db.isValid() ? db : QSqlDatabase::database()) {}
+	~QDuckDBTableModel() override { dropSnapshots(); }
+
+	/// sets the table or view and selects it. Without keyColumns the primary key or the rowid of a table is used,
+	/// pages of views without them are located with OFFSET only.
+	bool setTable(const QString &tableName, const QStringList &keyColumns = QStringList()) {
+		beginResetModel();
+		dropSnapshots();
+		m_table = tableName;
+		m_sortColumn = -1;
+		m_record = m_db.record(tableName);
+		m_keyColumns = keyColumns;
+		if (m_keyColumns.isEmpty()) {
+			const QSqlIndex primaryKey = m_db.primaryIndex(tableName);
+			for (int i = 0; i < primaryKey.count(); ++i)
+				m_keyColumns.append(primaryKey.fieldName(i));
+		}
+		if (m_keyColumns.isEmpty()) {
+			QSqlQuery probe(m_db);
+			if (probe.exec(QStringLiteral("SELECT rowid FROM %1 LIMIT 0").arg(escapedTable())))
+				m_keyColumns.append(QStringLiteral("rowid"));
+		}
+		resetPages();
+		const bool ok = selectCount();
+		endResetModel();
+		return ok && !m_record.isEmpty();
+	}
+
+	QString tableName() const { return m_table; }
+	QStringList keyColumns() const { return m_keyColumns; }
+	QSqlRecord record() const { return m_record; }
+	QSqlError lastError() const { return m_lastError; }
+
+	/// number of rows fetched with one query, 256 by default
+	void setPageSize(int rows) {
+		m_pageSize = qMax(1, rows);
+		resetPages();
+	}
+	int pageSize() const { return m_pageSize; }
+
+	/// number of converted pages kept in memory, 64 by default
+	void setCachedPages(int pages) {
+		m_pages.setMaxCost(qMax(1, pages));
+		m_anchors.setMaxCost(qMax(1, pages) * ANCHORS_PER_PAGE);
+	}
+	int cachedPages() const { return static_cast<int>(m_pages.maxCost()); }
+
+	/// starts with the estimated number of rows of the plan, so views can be shown without counting first.
+	/// The exact count follows from the event loop (or from a thread of the global QThreadPool if the database
+	/// uses SHARED_INSTANCE) and inserts or removes the difference. Off by default.
+	void setEstimatedRowCount(bool enabled) { m_estimateRowCount = enabled; }
+	bool estimatedRowCount() const { return m_estimateRowCount; }
+
+	/// counts the rows again and drops all cached pages
+	bool select() {
+		beginResetModel();
+		dropSnapshots();
+		resetPages();
+		const bool ok = selectCount();
+		endResetModel();
+		return ok;
+	}
+
+	/// applies the changes of the table since the last refresh() with rowsRemoved(), rowsInserted() and dataChanged()
+	/// instead of a reset, e.g. for views of live data. DuckDB compares the keys and a hash of every selected row with
+	/// a snapshot in a temporary table, only the positions of changed rows and the changed rows of cached pages are
+	/// fetched. Rows whose sort values changed are removed and inserted again.
+	/// The first refresh() after setTable(), select(), sort() or a filter change takes the snapshot with a reset and
+	/// creates its temporary tables. Later refreshes only replace their rows, so they keep the metadata cache of the
+	/// driver.
+	/// Without key columns it is the same as select().
+	bool refresh() {
+		if (m_record.isEmpty() || m_keyColumns.isEmpty())
+			return select();
+		if (m_snapshot < 0)
+			return selectSnapshot();
+		return refreshFromSnapshot();
+	}
+
+	/// sorts by the column with DuckDB, -1 restores the order of the key columns
+	void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override {
+		if (column >= m_record.count())
+			return;
+		beginResetModel();
+		m_sortColumn = column;
+		m_sortOrder = order;
+		dropSnapshots();
+		resetPages();
+		endResetModel();
+	}
+	int sortColumn() const { return m_sortColumn; }
+	Qt::SortOrder sortOrder() const { return m_sortOrder; }
+
+	/// filters the rows with an SQL condition like QSqlTableModel::setFilter, e.g. "price > ? AND kind = ?".
+	/// The values are bound to the placeholders of the condition.
+	bool setFilter(const QString &condition, const QVariantList &values = QVariantList()) {
+		m_filter = condition;
+		m_filterValues = values;
+		return select();
+	}
+	QString filter() const { return m_filter; }
+
+	/// keeps the rows whose column contains text, case insensitive. -1 searches all columns, an empty text
+	/// removes the filter.
+	bool setFilterFixedString(int column, const QString &text) {
+		m_searchColumn = column;
+		m_searchText = text;
+		return select();
+	}
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override {
+		return parent.isValid() ? 0 : m_rowCount;
+	}
+
+	int columnCount(const QModelIndex &parent = QModelIndex()) const override {
+		return parent.isValid() ? 0 : m_record.count();
+	}
+
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+		if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole))
+			return QVariant();
+		const int pageIndex = index.row() / m_pageSize;
+		const Page *page = m_pages.object(pageIndex);
+		if (!page)
+			page = fetchPage(pageIndex);
+		const int row = index.row() % m_pageSize;
+		if (!page || row >= page->rows.size())
+			return QVariant();
+		return page->rows.at(row).value(index.column());
+	}
+
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override {
+		if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section >= 0 && section < m_record.count())
+			return m_record.fieldName(section);
+		return QAbstractTableModel::headerData(section, orientation, role);
+	}
+
+protected:
+	struct Page {
+		QList<QVariantList> rows;
+	};
+
+	/// an ORDER BY term, rows are sorted with NULLS LAST
+	struct OrderTerm {
+		QString expression;
+		bool descending = false;
+	};
+
+	/// terms the rows are ordered by: the sort column, then the key columns which make the order total
+	virtual QList<OrderTerm> orderTerms() const {
+		QList<OrderTerm> terms;
+		if (m_sortColumn >= 0 && m_sortColumn < m_record.count())
+			terms.append({escapedField(m_record.fieldName(m_sortColumn)), m_sortOrder == Qt::DescendingOrder});
+		for (const auto &column : m_keyColumns)
+			terms.append({escapedField(column), false});
+		return terms;
+	}
+
+	/// condition of the WHERE clause, empty to select all rows
+	virtual QString filterClause() const {
+		QStringList conditions;
+		if (!m_filter.isEmpty())
+			conditions.append(QLatin1Char('(') + m_filter + QLatin1Char(')'));
+		if (!m_searchText.isEmpty()) {
+			QStringList matches;
+			for (int i = 0; i < m_record.count(); ++i) {
+				if (m_searchColumn < 0 || m_searchColumn == i)
+					matches.append(QStringLiteral("contains(lower(CAST(%1 AS VARCHAR)), lower(?))")
+					                   .arg(escapedField(m_record.fieldName(i))));
+			}
+			if (!matches.isEmpty())
+				conditions.append(QLatin1Char('(') + matches.join(QStringLiteral(" OR ")) + QLatin1Char(')'));
+		}
+		return conditions.join(QStringLiteral(" AND "));
+	}
+	/// values of the placeholders in filterClause()
+	virtual QVariantList filterValues() const {
+		QVariantList values = m_filterValues;
+		if (!m_searchText.isEmpty()) {
+			for (int i = 0; i < m_record.count(); ++i) {
+				if (m_searchColumn < 0 || m_searchColumn == i)
+					values.append(m_searchText);
+			}
+		}
+		return values;
+	}
+
+	void setLastError(const QSqlError &error) { m_lastError = error; }
+
+	QString escapedTable() const { return m_db.driver()->escapeIdentifier(m_table, QSqlDriver::TableName); }
+	QString escapedField(const QString &field) const {
+		return m_db.driver()->escapeIdentifier(field, QSqlDriver::FieldName);
+	}
+
+	QString whereClause(const QString &condition = QString()) const {
+		QStringList conditions;
+		const QString filter = filterClause();
+		if (!filter.isEmpty())
+			conditions.append(QLatin1Char('(') + filter + QLatin1Char(')'));
+		if (!condition.isEmpty())
+			conditions.append(condition);
+		return conditions.isEmpty() ? QString() : QStringLiteral(" WHERE ") + conditions.join(QStringLiteral(" AND "));
+	}
+
+	/// drops the cached pages, e.g. after the order or the filter changed
+	void resetPages() {
+		m_pages.clear();
+		m_anchors.clear();
+		m_orderTypesOf.clear();
+		m_orderTypes.clear();
+	}
+
+	void setRowCount(int rows) { m_rowCount = rows; }
+
+	bool selectCount() {
+		++m_countGeneration;
+		m_rowCount = 0;
+		if (m_record.isEmpty())
+			return false;
+		const QString sql = QStringLiteral("SELECT * FROM ") + escapedTable() + whereClause();
+		if (m_estimateRowCount) {
+			const qlonglong estimated = QDuckDBRowCount::estimate(m_db, sql, filterValues());
+			if (estimated >= 0) {
+				m_rowCount = clampedRows(estimated);
+				refineRowCount(sql);
+				return true;
+			}
+		}
+		qlonglong rows = 0;
+		if (!exactCount(sql, rows))
+			return false;
+		m_rowCount = clampedRows(rows);
+		return true;
+	}
+
+	QSqlDatabase database() const { return m_db; }
+
+private:
+	static constexpr int ANCHORS_PER_PAGE = 16;
+
+	// key of the first row of a page and of its last row, as text so no precision is lost on the way back
+	struct Anchor {
+		QStringList values;
+	};
+
+	bool fail(const QSqlQuery &query) const {
+		m_lastError = query.lastError();
+		return false;
+	}
+
+	static int clampedRows(qlonglong rows) {
+		return static_cast<int>(qBound<qlonglong>(0, rows, std::numeric_limits<int>::max()));
+	}
+
+	bool exactCount(const QString &sql, qlonglong &rows) {
+		QSqlQuery query(m_db);
+		query.setForwardOnly(true);
+		if (!query.prepare(QStringLiteral("SELECT count(*) FROM (") + sql + QStringLiteral(")")))
+			return fail(query);
+		for (const auto &value : filterValues())
+			query.addBindValue(value);
+		if (!query.exec() || !query.next())
+			return fail(query);
+		rows = query.value(0).toLongLong();
+		return true;
+	}
+
+	// replaces the estimated row count by the exact one, unless the model was selected again meanwhile
+	void refineRowCount(const QString &sql) {
+		const int generation = m_countGeneration;
+		if (QDuckDBAsync::detail::hasSharedInstance(m_db)) {
+			auto *watcher = new QFutureWatcher<QDuckDBAsyncResult>(this);
+			QObject::connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, generation]() {
+				watcher->deleteLater();
+				const QDuckDBAsyncResult result = watcher->result();
+				if (generation == m_countGeneration && !result.error.isValid() && !result.rows.isEmpty())
+					applyRowCount(clampedRows(result.rows.first().value(0).toLongLong()));
+			});
+			watcher->setFuture(QDuckDBRowCount::exact(m_db, sql, filterValues()));
+		} else {
+			QTimer::singleShot(0, this, [this, sql, generation]() {
+				qlonglong rows = 0;
+				if (generation == m_countGeneration && exactCount(sql, rows))
+					applyRowCount(clampedRows(rows));
+			});
+		}
+	}
+
+	void applyRowCount(int rows) {
+		if (rows > m_rowCount) {
+			beginInsertRows(QModelIndex(), m_rowCount, rows - 1);
+			m_rowCount = rows;
+			endInsertRows();
+		} else if (rows < m_rowCount) {
+			beginRemoveRows(QModelIndex(), rows, m_rowCount - 1);
+			m_rowCount = rows;
+			endRemoveRows();
+		}
+	}
+
+	static QStringList orderBy(const QList<OrderTerm> &terms) {
+		QStringList order;
+		for (const auto &term : terms) {
+			order.append(term.expression + (term.descending ? QStringLiteral(" DESC NULLS LAST")
+			                                                : QStringLiteral(" ASC NULLS LAST")));
+		}
+		return order;
+	}
+
+	static int nextSnapshotId() {
+		static std::atomic<int> counter {0};
+		return counter.fetch_add(1);
+	}
+
+	QString snapshotName(int snapshot) const {
+		return QStringLiteral("qt_duckdb_refresh_%1_%2").arg(m_snapshotId).arg(snapshot);
+	}
+
+	void dropSnapshots() {
+		if (m_snapshot < 0)
+			return;
+		m_snapshot = -1;
+		if (!m_db.isOpen())
+			return;
+		QSqlQuery query(m_db);
+		for (int snapshot = 0; snapshot < 2; ++snapshot)
+			query.exec(QStringLiteral("DROP TABLE IF EXISTS temp.") + snapshotName(snapshot));
+	}
+
+	// keys, hashes of the row and of its order values and position of every selected row. Creating the table is
+	// schema DDL, which drops the metadata cache of the driver, so only the first snapshot after a reset creates the
+	// tables and the refreshes replace their rows.
+	bool takeSnapshot(int snapshot, bool create) {
+		const QList<OrderTerm> terms = orderTerms();
+		QStringList orderValues;
+		for (const auto &term : terms)
+			orderValues.append(term.expression);
+		QStringList keys;
+		for (int i = 0; i < m_keyColumns.size(); ++i)
+			keys.append(QStringLiteral("%1 AS qt_key%2").arg(escapedField(m_keyColumns[i])).arg(i));
+		QStringList columns;
+		for (int i = 0; i < m_record.count(); ++i)
+			columns.append(escapedField(m_record.fieldName(i)));
+		const QString select =
+		    QStringLiteral("SELECT %1, hash(%2) AS qt_hash, hash(%3) AS qt_order_hash, "
+		                   "row_number() OVER (ORDER BY %4) - 1 AS qt_pos FROM %5%6")
+		        .arg(keys.join(QStringLiteral(", ")), columns.join(QStringLiteral(", ")),
+		             orderValues.join(QStringLiteral(", ")), orderBy(terms).join(QStringLiteral(", ")), escapedTable(),
+		             whereClause());
+		QSqlQuery query(m_db);
+		if (create) {
+			if (!query.prepare(
+			        QStringLiteral("CREATE OR REPLACE TEMP TABLE %1 AS %2").arg(snapshotName(snapshot), select)))
+				return fail(query);
+		} else {
+			if (!query.exec(QStringLiteral("DELETE FROM temp.") + snapshotName(snapshot)))
+				return fail(query);
+			if (!query.prepare(QStringLiteral("INSERT INTO temp.%1 %2").arg(snapshotName(snapshot), select)))
+				return fail(query);
+		}
+		for (const auto &value : filterValues())
+			query.addBindValue(value);
+		return query.exec() || fail(query);
+	}
+
+	// join condition of the keys of two snapshots, or of a snapshot and the table
+	QString keysEqual(const QString &left, const QString &right, bool rightIsTable = false) const {
+		QStringList conditions;
+		for (int i = 0; i < m_keyColumns.size(); ++i) {
+			conditions.append(QStringLiteral("%1.qt_key%2 = %3.%4")
+			                      .arg(left)
+			                      .arg(i)
+			                      .arg(right, rightIsTable ? escapedField(m_keyColumns[i])
+			                                               : QStringLiteral("qt_key%1").arg(i)));
+		}
+		return conditions.join(QStringLiteral(" AND "));
+	}
+
+	bool selectSnapshot() {
+		beginResetModel();
+		resetPages();
+		++m_countGeneration;
+		m_rowCount = 0;
+		QSqlQuery query(m_db);
+		query.setForwardOnly(true);
+		const bool ok =
+		    takeSnapshot(0, true) &&
+		    (query.exec(QStringLiteral("CREATE OR REPLACE TEMP TABLE %1 AS SELECT * FROM %2 LIMIT 0")
+		                    .arg(snapshotName(1), snapshotName(0))) ||
+		     fail(query)) &&
+		    ((query.exec(QStringLiteral("SELECT count(*) FROM ") + snapshotName(0)) && query.next()) || fail(query));
+		if (ok) {
+			m_snapshot = 0;
+			m_rowCount = clampedRows(query.value(0).toLongLong());
+		}
+		endResetModel();
+		return ok;
+	}
+
+	bool refreshFromSnapshot() {
+		const int next = 1 - m_snapshot;
+		if (!takeSnapshot(next, false))
+			return false;
+		const QString previousName = snapshotName(m_snapshot);
+		const QString nextName = snapshotName(next);
+
+		// removed rows by their old position, inserted and changed rows by their new position. Rows whose order values
+		// changed may have moved and are removed and inserted again, the others keep their relative order.
+		QSqlQuery diff(m_db);
+		diff.setForwardOnly(true);
+		const QString sql =
+		    QStringLiteral(
+		        "WITH common AS (SELECT o.qt_pos AS old_pos, n.qt_pos AS new_pos, o.qt_hash <> n.qt_hash AS changed, "
+		        "o.qt_order_hash <> n.qt_order_hash AS moved FROM %1 o JOIN %2 n ON %3) "
+		        "SELECT 0 AS kind, o.qt_pos AS pos FROM %1 o WHERE NOT EXISTS (SELECT 1 FROM %2 n WHERE %3) "
+		        "UNION ALL SELECT 0, old_pos FROM common WHERE moved "
+		        "UNION ALL SELECT 1, n.qt_pos FROM %2 n WHERE NOT EXISTS (SELECT 1 FROM %1 o WHERE %3) "
+		        "UNION ALL SELECT 1, new_pos FROM common WHERE moved "
+		        "UNION ALL SELECT 2, new_pos FROM common WHERE changed AND NOT moved "
+		        "ORDER BY kind, pos")
+		        .arg(previousName, nextName, keysEqual(QStringLiteral("o"), QStringLiteral("n")));
+		if (!diff.exec(sql))
+			return fail(diff);
+		QList<int> removed;
+		QList<int> inserted;
+		QList<int> changed;
+		while (diff.next()) {
+			const int position = diff.value(1).toInt();
+			switch (diff.value(0).toInt()) {
+			case 0:
+				removed.append(position);
+				break;
+			case 1:
+				inserted.append(position);
+				break;
+			default:
+				changed.append(position);
+				break;
+			}
+		}
+		if (diff.lastError().isValid())
+			return fail(diff);
+		m_snapshot = next;
+		++m_countGeneration;
+		const int removedCount = static_cast<int>(removed.size());
+		const int insertedCount = static_cast<int>(inserted.size());
+		const int changedCount = static_cast<int>(changed.size());
+		const int count = m_rowCount - removedCount + insertedCount;
+
+		// new positions of the cached rows which remain
+		QMap<int, QVariantList> rows;
+		{
+			QMap<int, QVariantList> cached;
+			for (const int pageIndex : m_pages.keys()) {
+				const Page *page = m_pages.object(pageIndex);
+				for (int i = 0; i < page->rows.size(); ++i)
+					cached.insert(pageIndex * m_pageSize + i, page->rows.at(i));
+			}
+			int r = 0;
+			int k = 0;
+			for (auto it = cached.cbegin(); it != cached.cend(); ++it) {
+				while (r < removedCount && removed[r] < it.key())
+					++r;
+				if (r < removedCount && removed[r] == it.key())
+					continue;
+				const int remaining = it.key() - r;
+				while (k < insertedCount && inserted[k] <= remaining + k)
+					++k;
+				rows.insert(remaining + k, it.value());
+			}
+		}
+
+		// cached pages are kept if only inserted and changed rows are missing, those are fetched
+		QList<int> keptPages;
+		QStringList fetched;
+		int checkedPage = -1;
+		for (auto it = rows.cbegin(); it != rows.cend(); ++it) {
+			const int pageIndex = it.key() / m_pageSize;
+			if (pageIndex == checkedPage)
+				continue;
+			checkedPage = pageIndex;
+			const int first = pageIndex * m_pageSize;
+			const int end = qMin(first + m_pageSize, count);
+			QStringList missing;
+			bool complete = true;
+			for (int position = first; position < end && complete; ++position) {
+				const bool isInserted = std::binary_search(inserted.cbegin(), inserted.cend(), position);
+				if (isInserted || std::binary_search(changed.cbegin(), changed.cend(), position))
+					missing.append(QString::number(position));
+				else
+					complete = rows.contains(position);
+			}
+			if (complete && first < end) {
+				keptPages.append(pageIndex);
+				fetched.append(missing);
+			}
+		}
+		if (!fetched.isEmpty()) {
+			QStringList columns;
+			for (int i = 0; i < m_record.count(); ++i)
+				columns.append(QStringLiteral("t.") + escapedField(m_record.fieldName(i)));
+			QSqlQuery query(m_db);
+			query.setForwardOnly(true);
+			if (query.exec(QStringLiteral("SELECT n.qt_pos, %1 FROM %2 n JOIN %3 t ON %4 WHERE n.qt_pos IN (%5)")
+			                   .arg(columns.join(QStringLiteral(", ")), nextName, escapedTable(),
+			                        keysEqual(QStringLiteral("n"), QStringLiteral("t"), true),
+			                        fetched.join(QStringLiteral(", "))))) {
+				const int columnCount = m_record.count();
+				while (query.next()) {
+					QVariantList row;
+					row.reserve(columnCount);
+					for (int i = 0; i < columnCount; ++i)
+						row.append(query.value(i + 1));
+					rows.insert(query.value(0).toInt(), row);
+				}
+			} else {
+				fail(query);
+				keptPages.clear();
+			}
+		}
+
+		m_pages.clear();
+		m_anchors.clear();
+		m_refreshing = true;
+		for (int i = removedCount - 1; i >= 0;) {
+			const int last = removed[i];
+			int first = last;
+			while (--i >= 0 && removed[i] == first - 1)
+				--first;
+			beginRemoveRows(QModelIndex(), first, last);
+			m_rowCount -= last - first + 1;
+			endRemoveRows();
+		}
+		for (int i = 0; i < insertedCount;) {
+			const int first = inserted[i];
+			int last = first;
+			while (++i < insertedCount && inserted[i] == last + 1)
+				++last;
+			beginInsertRows(QModelIndex(), first, last);
+			m_rowCount += last - first + 1;
+			endInsertRows();
+		}
+		m_refreshing = false;
+
+		for (const int pageIndex : qtAsConst(keptPages)) {
+			const int first = pageIndex * m_pageSize;
+			const int end = qMin(first + m_pageSize, count);
+			auto *page = new Page;
+			page->rows.reserve(end - first);
+			for (int position = first; position < end && rows.contains(position); ++position)
+				page->rows.append(rows.value(position));
+			if (page->rows.size() == end - first)
+				m_pages.insert(pageIndex, page);
+			else
+				delete page;
+		}
+		for (int i = 0; i < changedCount;) {
+			const int first = changed[i];
+			int last = first;
+			while (++i < changedCount && changed[i] == last + 1)
+				++last;
+			Q_EMIT dataChanged(index(first, 0), index(last, m_record.count() - 1));
+		}
+		return true;
+	}
+
+	// SQL types of the order terms, the keyset values are cast back to them
+	const QStringList &orderTypes(const QList<OrderTerm> &terms) const {
+		QStringList expressions;
+		for (const auto &term : terms)
+			expressions.append(term.expression);
+		if (!expressions.isEmpty() && expressions != m_orderTypesOf) {
+			m_orderTypesOf = expressions;
+			m_orderTypes.clear();
+			QSqlQuery query(m_db);
+			query.setForwardOnly(true);
+			if (query.exec(QStringLiteral("DESCRIBE SELECT ") + expressions.join(QStringLiteral(", ")) +
+			               QStringLiteral(" FROM ") + escapedTable())) {
+				while (query.next())
+					m_orderTypes.append(query.value(1).toString());
+			}
+		}
+		return m_orderTypes;
+	}
+
+	// rows after (or before) the row with the given order values, NULLS LAST
+	static QString keysetCondition(const QList<OrderTerm> &terms, const QStringList &types, const QStringList &values,
+	                               bool after, QVariantList &params, int term = 0) {
+		if (term == terms.size())
+			return QStringLiteral("FALSE");
+		const QString &expression = terms[term].expression;
+		const QString &value = values[term];
+		const QString typed = QStringLiteral("CAST(? AS %1)").arg(types[term]);
+		const bool greater = after != terms[term].descending;
+		QString condition;
+		if (value.isNull()) {
+			if (after) {
+				condition = QStringLiteral("(%1 IS NULL AND %2)")
+				                .arg(expression, keysetCondition(terms, types, values, after, params, term + 1));
+			} else {
+				condition = QStringLiteral("(%1 IS NOT NULL OR %2)")
+				                .arg(expression, keysetCondition(terms, types, values, after, params, term + 1));
+			}
+			return condition;
+		}
+		params.append(value);
+		params.append(value);
+		const QString next = keysetCondition(terms, types, values, after, params, term + 1);
+		condition = QStringLiteral("(%1 %2 %3 %4OR (%1 = %3 AND %5))")
+		                .arg(expression, greater ? QStringLiteral(">") : QStringLiteral("<"), typed,
+		                     after ? QStringLiteral("OR %1 IS NULL ").arg(expression) : QString(), next);
+		return condition;
+	}
+
+	const Page *fetchPage(int pageIndex) const {
+		// positions are inconsistent while refresh() emits its signals
+		if (m_refreshing)
+			return nullptr;
+		const QList<OrderTerm> terms = orderTerms();
+		QStringList columns;
+		for (int i = 0; i < m_record.count(); ++i)
+			columns.append(escapedField(m_record.fieldName(i)));
+		for (const auto &term : terms)
+			columns.append(QStringLiteral("CAST(%1 AS VARCHAR)").arg(term.expression));
+
+		const QStringList order = orderBy(terms);
+		QStringList reversedOrder;
+		for (const auto &term : terms) {
+			reversedOrder.append(term.expression + (term.descending ? QStringLiteral(" ASC NULLS FIRST")
+			                                                        : QStringLiteral(" DESC NULLS FIRST")));
+		}
+
+		// keyset pagination from a neighbouring page, OFFSET if no neighbour is known
+		QVariantList params = filterValues();
+		QString sql = QStringLiteral("SELECT ") + columns.join(QStringLiteral(", ")) + QStringLiteral(" FROM ") +
+		              escapedTable();
+		bool backwards = false;
+		const QStringList &types = orderTypes(terms);
+		const bool keyset = !terms.isEmpty() && types.size() == terms.size();
+		const Anchor *after = keyset ? m_anchors.object(startKey(pageIndex)) : nullptr;
+		const Anchor *before = keyset && !after ? m_anchors.object(endKey(pageIndex)) : nullptr;
+		if (after) {
+			sql += whereClause(keysetCondition(terms, types, after->values, true, params));
+		} else if (before) {
+			sql += whereClause(keysetCondition(terms, types, before->values, false, params));
+			backwards = true;
+		} else {
+			sql += whereClause();
+		}
+		if (!terms.isEmpty())
+			sql += QStringLiteral(" ORDER BY ") + (backwards ? reversedOrder : order).join(QStringLiteral(", "));
+		sql += QStringLiteral(" LIMIT %1").arg(m_pageSize);
+		if (!after && !before)
+			sql += QStringLiteral(" OFFSET %1").arg(static_cast<qint64>(pageIndex) * m_pageSize);
+
+		QSqlQuery query(m_db);
+		query.setForwardOnly(true);
+		if (!query.prepare(sql)) {
+			fail(query);
+			return nullptr;
+		}
+		for (const auto &param : qtAsConst(params))
+			query.addBindValue(param);
+		if (!query.exec()) {
+			fail(query);
+			return nullptr;
+		}
+
+		auto *page = new Page;
+		page->rows.reserve(m_pageSize);
+		const int columnCount = m_record.count();
+		QStringList firstKey;
+		QStringList lastKey;
+		while (query.next()) {
+			QVariantList row;
+			row.reserve(columnCount);
+			for (int i = 0; i < columnCount; ++i)
+				row.append(query.value(i));
+			page->rows.append(row);
+
+			QStringList key;
+			for (int i = 0; i < terms.size(); ++i)
+				key.append(query.value(columnCount + i).isNull() ? QString() : query.value(columnCount + i).toString());
+			if (firstKey.isEmpty() && !key.isEmpty())
+				firstKey = key;
+			lastKey = key;
+		}
+		if (backwards) {
+			std::reverse(page->rows.begin(), page->rows.end());
+			std::swap(firstKey, lastKey);
+		}
+		if (!terms.isEmpty() && !page->rows.isEmpty()) {
+			// the neighbours of this page start after its last row and end before its first row
+			m_anchors.insert(startKey(pageIndex + 1), new Anchor {lastKey});
+			if (pageIndex > 0)
+				m_anchors.insert(endKey(pageIndex - 1), new Anchor {firstKey});
+		}
+		m_pages.insert(pageIndex, page);
+		return page;
+	}
+
+	// anchors of both kinds share one cache
+	static qint64 startKey(int pageIndex) { return static_cast<qint64>(pageIndex) * 2; }
+	static qint64 endKey(int pageIndex) { return static_cast<qint64>(pageIndex) * 2 + 1; }
+
+	QSqlDatabase m_db;
+	QString m_table;
+	QStringList m_keyColumns;
+	QSqlRecord m_record;
+	int m_rowCount = 0;
+	int m_pageSize = 256;
+	bool m_estimateRowCount = false;
+	int m_countGeneration = 0;
+	int m_sortColumn = -1;
+	Qt::SortOrder m_sortOrder = Qt::AscendingOrder;
+	QString m_filter;
+	QVariantList m_filterValues;
+	int m_searchColumn = -1;
+	QString m_searchText;
+	mutable QCache<int, Page> m_pages {64};
+	mutable QCache<qint64, Anchor> m_anchors {64 * ANCHORS_PER_PAGE};
+	mutable QSqlError m_lastError;
+	mutable QStringList m_orderTypesOf;
+	mutable QStringList m_orderTypes;
+	// temporary tables of refresh(), m_snapshot is the current one or -1
+	int m_snapshotId = nextSnapshotId();
+	int m_snapshot = -1;
+	bool m_refreshing = false;
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "QDuckDBColumns.h"
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QString>
+#include <QVariant>
+#include <iterator>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Converters between the columns of QDuckDBColumns and C++ types, chosen at compile time by QDuckDBTypedQuery.
+/// Specialize Converter for further types, e.g. a QDateTime read from a Text column:
+///
+///     template <> struct QDuckDBTyped::Converter<QDateTime> {
+///         static bool accepts(QDuckDBColumn::Type type) { return type == QDuckDBColumn::Text; }
+///         static QDateTime value(const QDuckDBColumn &column, qsizetype row) { ... }
+///         static QVariant parameter(const QDateTime &value) { return value; }
+///     };
+namespace QDuckDBTyped {
+
+namespace detail {
+// index type of the Qt containers of QDuckDBColumn, int in Qt 5
+template <typename Container>
+auto index(const Container &container, qsizetype i) {
+	return static_cast<decltype(container.size())>(i);
+}
+} // namespace detail
+
+template <typename T, typename = void>
+struct Converter;
+
+/// bool and integers from Integer columns, UBIGINT and HUGEINT columns are Text and read as QString
+template <typename T>
+struct Converter<T, std::enable_if_t<std::is_integral_v<T>>> {
+	static bool accepts(QDuckDBColumn::Type type) { return type == QDuckDBColumn::Integer; }
+	static T value(const QDuckDBColumn &column, qsizetype row) {
+		return static_cast<T>(column.integers.constData()[row]);
+	}
+	static QVariant parameter(T value) {
+		if constexpr (std::is_same_v<T, bool>)
+			return QVariant(value);
+		else if constexpr (std::is_signed_v<T>)
+			return QVariant(static_cast<qlonglong>(value));
+		else
+			return QVariant(static_cast<qulonglong>(value));
+	}
+};
+
+/// float and double from Real and Integer columns
+template <typename T>
+struct Converter<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+	static bool accepts(QDuckDBColumn::Type type) {
+		return type == QDuckDBColumn::Real || type == QDuckDBColumn::Integer;
+	}
+	static T value(const QDuckDBColumn &column, qsizetype row) {
+		if (column.type == QDuckDBColumn::Integer)
+			return static_cast<T>(column.integers.constData()[row]);
+		return static_cast<T>(column.reals.constData()[row]);
+	}
+	static QVariant parameter(T value) { return QVariant(static_cast<double>(value)); }
+};
+
+/// QString from Text columns
+template <>
+struct Converter<QString> {
+	static bool accepts(QDuckDBColumn::Type type) { return type == QDuckDBColumn::Text; }
+	static QString value(const QDuckDBColumn &column, qsizetype row) {
+		return column.texts.at(detail::index(column.texts, row));
+	}
+	static QVariant parameter(const QString &value) { return QVariant(value); }
+};
+
+/// std::optional<T> for columns with NULL values, which T reads as 0 or an empty string
+template <typename T>
+struct Converter<std::optional<T>> {
+	static bool accepts(QDuckDBColumn::Type type) { return Converter<T>::accepts(type); }
+	static std::optional<T> value(const QDuckDBColumn &column, qsizetype row) {
+		if (!column.valid.testBit(detail::index(column.valid, row)))
+			return std::nullopt;
+		return Converter<T>::value(column, row);
+	}
+	static QVariant parameter(const std::optional<T> &value) {
+		return value ? Converter<T>::parameter(*value) : QVariant();
+	}
+};
+
+} // namespace QDuckDBTyped
+
+/// Query with a row shape known at compile time, e.g. QDuckDBTypedQuery<qint64, QString, std::optional<double>>.
+/// exec() checks the columns of the result against Ts once, then converts whole columns with the converters of Ts
+/// instead of boxing every value in a QVariant:
+///
+///     QDuckDBTypedQuery<qint64, QString, double> query(db);
+///     if (query.exec("SELECT id, name, price FROM items WHERE price > ?", 100.0)) {
+///         for (const auto &[id, name, price] : query.rows())
+///             ...
+///     }
+///     struct Item { qint64 id; QString name; double price; };
+///     std::vector<Item> items = query.as<Item>();
+///
+/// Parameters are bound with the converters of their types too, so unsupported types fail to compile.
+template <typename... Ts>
+class QDuckDBTypedQuery {
+public:
+	using Row = std::tuple<Ts...>;
+
+	explicit QDuckDBTypedQuery(const QSqlDatabase &db = QSqlDatabase::database()) : m_query(db) {
+		m_query.setForwardOnly(true);
+	}
+
+	/// executes sql with the positional params and converts all rows of its result.
+	/// Returns false on errors or if the result does not have the columns Ts, see lastError().
+	template <typename... Params>
+	bool exec(const QString &sql, const Params &...params) {
+		m_rows.clear();
+		m_lastError = QSqlError();
+		if (!m_query.prepare(sql)) {
+			m_lastError = m_query.lastError();
+			return false;
+		}
+		(m_query.addBindValue(QDuckDBTyped::Converter<Params>::parameter(params)), ...);
+		if (!m_query.exec()) {
+			m_lastError = m_query.lastError();
+			return false;
+		}
+		QVector<QDuckDBColumn> columns;
+		if (!QDuckDBColumns::fetch(m_query, columns)) {
+			m_lastError = m_query.driver()->lastError();
+			return false;
+		}
+		if (!checkColumns(columns, std::index_sequence_for<Ts...>()))
+			return false;
+		const qsizetype count = columns.isEmpty() ? 0 : columns.first().size();
+		m_rows.reserve(static_cast<size_t>(count));
+		for (qsizetype row = 0; row < count; ++row)
+			m_rows.push_back(makeRow(columns, row, std::index_sequence_for<Ts...>()));
+		return true;
+	}
+
+	const std::vector<Row> &rows() const { return m_rows; }
+
+	/// the rows as aggregates initialized with the values of a row, e.g. struct Item { qint64 id; QString name; }
+	template <typename Struct>
+	std::vector<Struct> as() const {
+		std::vector<Struct> values;
+		values.reserve(m_rows.size());
+		for (const auto &row : m_rows)
+			values.push_back(std::apply([](const Ts &...value) { return Struct {value...}; }, row));
+		return values;
+	}
+
+	QSqlError lastError() const { return m_lastError; }
+	QSqlQuery &query() { return m_query; }
+
+private:
+	template <size_t... I>
+	bool checkColumns(const QVector<QDuckDBColumn> &columns, std::index_sequence<I...>) {
+		if (columns.size() != static_cast<qsizetype>(sizeof...(Ts))) {
+			m_lastError = QSqlError(QStringLiteral("Unexpected result"),
+			                        QStringLiteral("The result has %1 columns, the row type %2")
+			                            .arg(columns.size())
+			                            .arg(sizeof...(Ts)),
+			                        QSqlError::StatementError);
+			return false;
+		}
+		const bool accepted[] = {true, QDuckDBTyped::Converter<Ts>::accepts(columns.at(static_cast<int>(I)).type)...};
+		for (size_t i = 1; i < std::size(accepted); ++i) {
+			if (!accepted[i]) {
+				m_lastError = QSqlError(QStringLiteral("Unexpected result"),
+				                        QStringLiteral("The type of column %1 does not match the row type")
+				                            .arg(columns.at(static_cast<int>(i - 1)).name),
+				                        QSqlError::StatementError);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <size_t... I>
+	static Row makeRow(const QVector<QDuckDBColumn> &columns, qsizetype row, std::index_sequence<I...>) {
+		return Row {QDuckDBTyped::Converter<Ts>::value(columns.at(static_cast<int>(I)), row)...};
+	}
+
+	QSqlQuery m_query;
+	std::vector<Row> m_rows;
+	QSqlError m_lastError;
+};
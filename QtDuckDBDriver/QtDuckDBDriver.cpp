@@ -1,27 +1,113 @@
 #include "QtDuckDBDriver.h"
 
+#include "QDuckDBColumns.h"
+#include "QDuckDBFunction.h"
 #include "Qt5Compat.h"
 
+#include <QAbstractItemModel>
 #include <QCoreApplication>
 #include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QList>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QResource>
 #include <QScopedValueRollback>
 #include <QSqlError>
 #include <QSqlField>
 #include <QSqlIndex>
 #include <QSqlQuery>
+#include <QThread>
+#include <QUuid>
 #include <QVariant>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <duckdb.hpp>
+#include <duckdb/catalog/catalog.hpp>
+#include <duckdb/common/arrow/arrow_wrapper.hpp>
+#include <duckdb/common/arrow/result_arrow_wrapper.hpp>
+#include <duckdb/common/types/column/column_data_collection.hpp>
+#include <duckdb/common/vector_operations/vector_operations.hpp>
+#include <duckdb/execution/expression_executor.hpp>
+#include <duckdb/execution/operator/scan/physical_table_scan.hpp>
+#include <duckdb/execution/physical_plan_generator.hpp>
+#include <duckdb/function/table/arrow.hpp>
+#include <duckdb/function/udf_function.hpp>
+#include <duckdb/main/db_instance_cache.hpp>
+#include <duckdb/main/extension_helper.hpp>
+#include <duckdb/main/prepared_statement_data.hpp>
+#include <duckdb/parser/parsed_data/create_aggregate_function_info.hpp>
+#include <duckdb/parser/parsed_data/create_table_function_info.hpp>
 #include <duckdb/parser/parser.hpp>
+#include <duckdb/parser/statement/transaction_statement.hpp>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <private/qsqlcachedresult_p.h>
 #include <private/qsqldriver_p.h>
+#include <set>
+#include <thread>
+#include <unordered_map>
 
 struct DbHandle {
-	duckdb::unique_ptr<duckdb::DuckDB> db;
+	// shared, as connections opened with SHARED_INSTANCE attach to the same instance
+	duckdb::shared_ptr<duckdb::DuckDB> db;
 	duckdb::unique_ptr<duckdb::Connection> con;
 };
 
+// Instances opened with the SHARED_INSTANCE option, keyed by their database path.
+// The cache only holds weak references, the instance is destroyed with its last connection.
+static duckdb::DBInstanceCache &sharedInstanceCache() {
+	static duckdb::DBInstanceCache cache;
+	return cache;
+}
+
+// conversion of a result column to QVariant, resolved once from the column type
+enum class ColumnConversion : uint8_t { Blob, Signed, Unsigned, Floating, Decimal, TimestampTz, Uuid, String };
+
+static ColumnConversion qColumnConversion(duckdb::LogicalTypeId type) {
+	switch (type) {
+	case duckdb::LogicalTypeId::BLOB:
+		return ColumnConversion::Blob;
+	case duckdb::LogicalTypeId::BOOLEAN:
+	case duckdb::LogicalTypeId::TINYINT:
+	case duckdb::LogicalTypeId::SMALLINT:
+	case duckdb::LogicalTypeId::INTEGER:
+	case duckdb::LogicalTypeId::BIGINT:
+		return ColumnConversion::Signed;
+	case duckdb::LogicalTypeId::UTINYINT:
+	case duckdb::LogicalTypeId::USMALLINT:
+	case duckdb::LogicalTypeId::UINTEGER:
+	case duckdb::LogicalTypeId::UBIGINT:
+		return ColumnConversion::Unsigned;
+	case duckdb::LogicalTypeId::FLOAT:
+	case duckdb::LogicalTypeId::DOUBLE:
+		return ColumnConversion::Floating;
+	case duckdb::LogicalTypeId::DECIMAL:
+		return ColumnConversion::Decimal;
+	case duckdb::LogicalTypeId::TIMESTAMP_TZ:
+		return ColumnConversion::TimestampTz;
+	case duckdb::LogicalTypeId::UUID:
+		return ColumnConversion::Uuid;
+	default:
+		return ColumnConversion::String;
+	}
+}
+
 struct DuckDBStmt {
 	duckdb::shared_ptr<duckdb::ClientContext> context;
 	//! The prepared statement object, if successfully prepared
@@ -35,8 +121,292 @@ struct DuckDBStmt {
 	//! Bound values, used for binding to the prepared statement
 	duckdb::vector<duckdb::Value> bound_values;
 	int64_t last_changes = 0;
+	//! Timeout of the current execution, 0 if there is none
+	std::chrono::milliseconds timeout {0};
+	//! Part of the timeout not spent executing and fetching yet, the time between two fetches does not count
+	std::chrono::steady_clock::duration remaining {};
+	//! Record of the result columns, built again when their names or types change
+	QSqlRecord record;
+	//! How the values of each result column are converted to QVariant
+	duckdb::vector<ColumnConversion> conversions;
+	//! Names and types the record was built for
+	duckdb::vector<std::string> record_names;
+	duckdb::vector<duckdb::LogicalType> record_types;
+	//! Query of prepared, preparing it again keeps the statement while the schema did not change
+	QString query;
+	//! Schema generation of the driver when prepared was prepared
+	quint64 schema_generation = 0;
+	//! Whether prepare() kept prepared for the same query, it is prepared again if it no longer executes
+	bool reused = false;
+};
+
+// Session setting which overrides the QUERY_TIMEOUT_MS connection option for the following statements
+static constexpr const char *QUERY_TIMEOUT_SETTING = "qtduckdb_query_timeout_ms";
+
+// Interrupts statements which run longer than their timeout. One thread serves all connections, it runs while a
+// driver is open.
+class QueryWatchdog {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static QueryWatchdog &instance() {
+		static QueryWatchdog watchdog;
+		return watchdog;
+	}
+
+	~QueryWatchdog() {
+		stop();
+	}
+
+	// called when a driver opens
+	void retain() {
+		std::lock_guard<std::mutex> lock(mutex);
+		++drivers;
+	}
+
+	// called when a driver closes, the last one stops the thread while Qt is still alive
+	void release() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (drivers > 0 && --drivers > 0)
+				return;
+		}
+		stop();
+	}
+
+	uint64_t arm(const duckdb::shared_ptr<duckdb::ClientContext> &context, Clock::time_point deadline) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!thread.joinable())
+			thread = std::thread([this, current = generation]() { run(current); });
+		const uint64_t ticket = ++lastTicket;
+		deadlines.emplace(ticket, Deadline {deadline, context, false});
+		wakeup.notify_all();
+		return ticket;
+	}
+
+	// returns true if the statement was interrupted by the watchdog
+	bool disarm(uint64_t ticket) {
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = deadlines.find(ticket);
+		if (it == deadlines.end())
+			return false;
+		const bool expired = it->second.expired;
+		deadlines.erase(it);
+		return expired;
+	}
+
+private:
+	struct Deadline {
+		Clock::time_point at;
+		duckdb::weak_ptr<duckdb::ClientContext> context;
+		bool expired;
+	};
+
+	// ends the thread, the next arm() starts another one
+	void stop() {
+		std::thread stopped;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			++generation;
+			stopped = std::move(thread);
+		}
+		wakeup.notify_all();
+		if (stopped.joinable())
+			stopped.join();
+	}
+
+	void run(uint64_t current) {
+		std::unique_lock<std::mutex> lock(mutex);
+		while (current == generation) {
+			const auto now = Clock::now();
+			auto next = Clock::time_point::max();
+			for (auto &entry : deadlines) {
+				Deadline &deadline = entry.second;
+				if (deadline.expired)
+					continue;
+				if (deadline.at <= now) {
+					if (auto context = deadline.context.lock())
+						context->Interrupt();
+					deadline.expired = true;
+				} else {
+					next = std::min(next, deadline.at);
+				}
+			}
+			if (next == Clock::time_point::max())
+				wakeup.wait(lock);
+			else
+				wakeup.wait_until(lock, next);
+		}
+	}
+
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	std::map<uint64_t, Deadline> deadlines;
+	std::thread thread;
+	uint64_t lastTicket = 0;
+	// the thread of a generation ends when stop() starts the next one
+	uint64_t generation = 0;
+	int drivers = 0;
+};
+
+// Arms the watchdog for the lifetime of the guard, if the statement has a timeout. The timeout is a total over
+// the execution and all fetches of the statement, each guard gets the part the previous ones did not spend.
+class QueryTimeoutGuard {
+public:
+	explicit QueryTimeoutGuard(DuckDBStmt &stmt) : stmt(stmt) {
+		if (stmt.timeout.count() > 0) {
+			started = QueryWatchdog::Clock::now();
+			ticket = QueryWatchdog::instance().arm(stmt.context, started + stmt.remaining);
+		}
+	}
+	~QueryTimeoutGuard() {
+		release();
+	}
+	QueryTimeoutGuard(const QueryTimeoutGuard &) = delete;
+	QueryTimeoutGuard &operator=(const QueryTimeoutGuard &) = delete;
+
+	// disarms the watchdog, returns true if the statement was interrupted because of the timeout
+	bool release() {
+		if (ticket != 0) {
+			expired = QueryWatchdog::instance().disarm(ticket);
+			ticket = 0;
+			stmt.remaining -= std::min(stmt.remaining, QueryWatchdog::Clock::now() - started);
+		}
+		return expired;
+	}
+
+private:
+	DuckDBStmt &stmt;
+	QueryWatchdog::Clock::time_point started;
+	uint64_t ticket = 0;
+	bool expired = false;
 };
 
+// Options given to QDuckDBDriver::open() as "KEY=VALUE;FLAG;..."
+struct ConnectOptions {
+	bool readOnly = false;
+	bool sharedInstance = false;
+	// create the instance with the first statement instead of in open()
+	bool lazyOpen = false;
+	// linked extensions which are loaded with the first statement instead of with the instance
+	QStringList deferredExtensions;
+	std::chrono::milliseconds queryTimeout {0};
+	// sampling interval of queryProgress(), 0 disables progress reporting
+	qint64 progressInterval = 0;
+	// DuckDB settings applied to the DBConfig of the instance
+	std::vector<std::pair<std::string, std::string>> settings;
+};
+
+// Connection options which map to a setting of duckdb::DBConfig. The values are converted and
+// validated by DuckDB when the instance is configured.
+static const struct {
+	const char *option;
+	const char *setting;
+} DUCKDB_SETTING_OPTIONS[] = {
+    {"THREADS", "threads"},
+    {"EXTERNAL_THREADS", "external_threads"},
+    {"MEMORY_LIMIT", "memory_limit"},
+    {"TEMP_DIRECTORY", "temp_directory"},
+    {"MAX_TEMP_DIRECTORY_SIZE", "max_temp_directory_size"},
+    {"PRESERVE_INSERTION_ORDER", "preserve_insertion_order"},
+    {"CHECKPOINT_THRESHOLD", "checkpoint_threshold"},
+    {"ENABLE_OBJECT_CACHE", "enable_object_cache"},
+    {"ALLOCATOR_FLUSH_THRESHOLD", "allocator_flush_threshold"},
+    {"ALLOCATOR_BULK_DEALLOCATION_FLUSH_THRESHOLD", "allocator_bulk_deallocation_flush_threshold"},
+    {"ALLOCATOR_BACKGROUND_THREADS", "allocator_background_threads"},
+};
+
+// names of the extensions linked into the driver, defined by the build
+static QStringList qLinkedExtensions() {
+	return QString::fromLatin1(QTDUCKDB_LINKED_EXTENSIONS).split(u',', Qt::SkipEmptyParts);
+}
+
+// loads a linked extension unless the (possibly shared) instance has loaded it already
+static void qLoadLinkedExtension(duckdb::DuckDB &db, const QString &name) {
+	const std::string extension = name.toStdString();
+	if (db.ExtensionIsLoaded(extension))
+		return;
+	if (duckdb::ExtensionHelper::LoadExtension(db, extension) != duckdb::ExtensionLoadResult::LOADED_EXTENSION)
+		throw duckdb::InvalidInputException("Extension \"%s\" is not linked into the driver", extension);
+}
+
+static bool qParseConnectOptions(const QString &conOpts, ConnectOptions &options, QString &errorText) {
+	auto invalidValue = [&errorText](const QString &key) {
+		errorText = QCoreApplication::translate("QDuckDBDriver", "Invalid value for connection option %1").arg(key);
+		return false;
+	};
+	auto parseMilliseconds = [](const QString &value, qint64 &result) {
+		bool ok = false;
+		result = value.toLongLong(&ok);
+		return ok && result >= 0;
+	};
+
+	for (const auto &entry : conOpts.split(u';')) {
+		const QString option = entry.trimmed();
+		if (option.isEmpty())
+			continue;
+		const auto separator = option.indexOf(u'=');
+		const QString key = (separator < 0 ? option : option.left(separator)).trimmed().toUpper();
+		const QString value = separator < 0 ? QString() : option.mid(separator + 1).trimmed();
+
+		if (key == "READONLY"_L1 || key == "SHARED_INSTANCE"_L1 || key == "LAZY_OPEN"_L1) {
+			// flags do not take a value
+			if (separator >= 0)
+				return invalidValue(key);
+			if (key == "READONLY"_L1)
+				options.readOnly = true;
+			else if (key == "SHARED_INSTANCE"_L1)
+				options.sharedInstance = true;
+			else
+				options.lazyOpen = true;
+			continue;
+		}
+		if (key == "DEFER_EXTENSIONS"_L1) {
+			const QStringList linked = qLinkedExtensions();
+			for (const auto &name : value.split(u',', Qt::SkipEmptyParts)) {
+				const QString extension = name.trimmed().toLower();
+				if (!linked.contains(extension)) {
+					errorText = QCoreApplication::translate("QDuckDBDriver", "Extension %1 is not linked into the driver")
+					                .arg(extension);
+					return false;
+				}
+				options.deferredExtensions.append(extension);
+			}
+			if (options.deferredExtensions.isEmpty())
+				return invalidValue(key);
+			continue;
+		}
+		if (key == "QUERY_TIMEOUT_MS"_L1) {
+			qint64 timeout = 0;
+			if (!parseMilliseconds(value, timeout))
+				return invalidValue(key);
+			options.queryTimeout = std::chrono::milliseconds(timeout);
+			continue;
+		}
+		if (key == "PROGRESS_INTERVAL_MS"_L1) {
+			if (!parseMilliseconds(value, options.progressInterval))
+				return invalidValue(key);
+			continue;
+		}
+
+		bool known = false;
+		for (const auto &setting : DUCKDB_SETTING_OPTIONS) {
+			if (key == QLatin1String(setting.option)) {
+				if (value.isEmpty())
+					return invalidValue(key);
+				options.settings.emplace_back(setting.setting, value.toStdString());
+				known = true;
+				break;
+			}
+		}
+		if (!known) {
+			errorText = QCoreApplication::translate("QDuckDBDriver", "Unknown connection option %1").arg(key);
+			return false;
+		}
+	}
+	return true;
+}
+
 static QString _q_escapeIdentifier(const QString &identifier, QSqlDriver::IdentifierType type) {
 	QString res = identifier;
 	// If it contains [ and ] then we assume it to be escaped properly already as this indicates
@@ -52,8 +422,8 @@ static QString _q_escapeIdentifier(const QString &identifier, QSqlDriver::Identi
 	return res;
 }
 
-static QMetaType::Type duckdbTypeToQtType(const duckdb::LogicalType &type) {
-	switch (type.id()) {
+static QMetaType::Type duckdbTypeToQtType(duckdb::LogicalTypeId type) {
+	switch (type) {
 	case duckdb::LogicalTypeId::BOOLEAN:
 		return QMetaType::Bool;
 	case duckdb::LogicalTypeId::TINYINT:
@@ -62,6 +432,9 @@ static QMetaType::Type duckdbTypeToQtType(const duckdb::LogicalType &type) {
 		return QMetaType::Short;
 	case duckdb::LogicalTypeId::INTEGER:
 		return QMetaType::Int;
+	case duckdb::LogicalTypeId::UTINYINT:
+	case duckdb::LogicalTypeId::USMALLINT:
+	case duckdb::LogicalTypeId::UINTEGER:
 	case duckdb::LogicalTypeId::UBIGINT:
 		return QMetaType::ULongLong;
 	case duckdb::LogicalTypeId::BIGINT:
@@ -80,9 +453,17 @@ static QMetaType::Type duckdbTypeToQtType(const duckdb::LogicalType &type) {
 	case duckdb::LogicalTypeId::TIMESTAMP_NS:
 	case duckdb::LogicalTypeId::TIMESTAMP_MS:
 	case duckdb::LogicalTypeId::TIMESTAMP_SEC:
+	case duckdb::LogicalTypeId::TIMESTAMP_TZ:
+		// with the milliseconds of QDateTime, infinite values are fetched as text
 		return QMetaType::QDateTime;
+	case duckdb::LogicalTypeId::UUID:
+		return QMetaType::QUuid;
 	case duckdb::LogicalTypeId::DECIMAL:
+		// like numeric columns of the other Qt drivers, fetched exactly as QString with QSql::HighPrecision
 		return QMetaType::Double;
+	case duckdb::LogicalTypeId::HUGEINT:
+	case duckdb::LogicalTypeId::UHUGEINT:
+		// QVariant has no 128-bit integers, the text is exact
 	case duckdb::LogicalTypeId::VARCHAR:
 	case duckdb::LogicalTypeId::LIST:
 	case duckdb::LogicalTypeId::MAP:
@@ -92,794 +473,3189 @@ static QMetaType::Type duckdbTypeToQtType(const duckdb::LogicalType &type) {
 	}
 }
 
-static duckdb::LogicalTypeId duckdbTypeIdFromName(const QString &tpName) {
-	const QString typeName = tpName.toLower();
-
-	if (typeName == "tinyint"_L1)
-		return duckdb::LogicalTypeId::TINYINT;
-	if (typeName == "smallint"_L1 || typeName == "int2"_L1)
-		return duckdb::LogicalTypeId::SMALLINT;
-	if (typeName == "integer"_L1 || typeName == "int"_L1 || typeName == "int4"_L1)
-		return duckdb::LogicalTypeId::INTEGER;
-	if (typeName == "bigint"_L1 || typeName == "int8"_L1)
-		return duckdb::LogicalTypeId::BIGINT;
-	if (typeName == "ubigint"_L1)
-		return duckdb::LogicalTypeId::UBIGINT;
-	if (typeName == "float"_L1 || typeName == "real"_L1 || typeName == "float4"_L1)
-		return duckdb::LogicalTypeId::FLOAT;
-	if (typeName == "double"_L1 || typeName == "float8"_L1 || typeName.startsWith("numeric"_L1) ||
-	    typeName.startsWith("decimal"_L1))
-		return duckdb::LogicalTypeId::DOUBLE;
-	if (typeName == "blob"_L1)
-		return duckdb::LogicalTypeId::BLOB;
-	if (typeName == "boolean"_L1 || typeName == "bool"_L1)
-		return duckdb::LogicalTypeId::BOOLEAN;
-	if (typeName == "date"_L1)
-		return duckdb::LogicalTypeId::DATE;
-	if (typeName == "time"_L1)
-		return duckdb::LogicalTypeId::TIME;
-	if (typeName == "timestamp"_L1)
-		return duckdb::LogicalTypeId::TIMESTAMP;
-	return duckdb::LogicalTypeId::VARCHAR;
-}
-
-static QMetaType::Type qGetColumnType(const QString &tpName) {
-	return duckdbTypeToQtType(duckdb::LogicalType(duckdbTypeIdFromName(tpName)));
-}
-
 static QSqlError qMakeError(duckdb::ErrorData &errData, const QString &descr, QSqlError::ErrorType type) {
 	return QSqlError(descr, QString::fromStdString(errData.Message()), type,
 	                 QString::fromStdString(duckdb::Exception::ExceptionTypeToString(errData.Type())));
 }
 
-class QDuckDBResultPrivate;
+// converts a bound value to the type DuckDB binds it as
+static duckdb::Value qToDuckDBValue(const QVariant &value) {
+	if (value.isNull())
+		return duckdb::Value();
+	switch (value.userType()) {
+	case QMetaType::QByteArray: {
+		const QByteArray *ba = static_cast<const QByteArray *>(value.constData());
+		return duckdb::Value::BLOB_RAW(ba->toStdString());
+	}
+	case QMetaType::Bool:
+	case QMetaType::Char:
+	case QMetaType::SChar:
+	case QMetaType::Short:
+	case QMetaType::Int:
+	case QMetaType::Long:
+	case QMetaType::LongLong:
+		return duckdb::Value::BIGINT(value.toLongLong());
+	case QMetaType::Double:
+		return duckdb::Value::DOUBLE(value.toDouble());
+	case QMetaType::Float:
+		return duckdb::Value::DOUBLE(static_cast<double>(value.toFloat()));
+	case QMetaType::UChar:
+	case QMetaType::UShort:
+	case QMetaType::UInt:
+	case QMetaType::ULong:
+	case QMetaType::ULongLong:
+		return duckdb::Value::UBIGINT(value.toULongLong());
+	case QMetaType::QDateTime: {
+		const QDateTime dateTime = value.toDateTime();
+		const QString str = dateTime.toString(Qt::ISODateWithMs);
+		return duckdb::Value(str.toStdString());
+	}
+	case QMetaType::QDate: {
+		const QDate date = value.toDate();
+		const QString str = date.toString(Qt::ISODate);
+		return duckdb::Value(str.toStdString());
+	}
+	case QMetaType::QTime: {
+		const QTime time = value.toTime();
+		const QString str = time.toString(u"hh:mm:ss.zzz");
+		return duckdb::Value(str.toStdString());
+	}
+	case QMetaType::QString: {
+		const QString *str = static_cast<const QString *>(value.constData());
+		return duckdb::Value(str->toUtf8().toStdString());
+	}
+	case QMetaType::QUuid:
+		return duckdb::Value(value.toUuid().toString(QUuid::WithoutBraces).toStdString());
+	default: {
+		const QString str = value.toString();
+		return duckdb::Value(str.toStdString());
+	}
+	}
+}
 
-class QDuckDBResult : public QSqlCachedResult {
-	Q_DECLARE_PRIVATE(QDuckDBResult)
-	friend class QDuckDBDriver;
+// A Qt item model or fixed-width columns of an array, scanned by the qt_source table function
+struct ScanColumn {
+	std::string name;
+	duckdb::LogicalType type;
+	const char *data = nullptr;
+	qlonglong stride = 0;
+};
 
-public:
-	explicit QDuckDBResult(const QDuckDBDriver *db);
-	~QDuckDBResult();
+struct ScanSource {
+	// set for models, which are copied before each statement reading them
+	QPointer<QAbstractItemModel> model;
+	// rows and columns of registerColumns()
+	duckdb::idx_t rows = 0;
+	duckdb::vector<ScanColumn> columns;
+	// rows and columns of the model copied for the last statement, nullptr for the columns it does not reference
+	std::mutex snapshotMutex;
+	duckdb::idx_t snapshotRows = 0;
+	duckdb::vector<std::shared_ptr<duckdb::ColumnDataCollection>> snapshot;
+};
 
-protected:
-	bool gotoNext(QSqlCachedResult::ValueCache &row, int idx) override;
-	bool reset(const QString &query) override;
-	bool prepare(const QString &query) override;
-	bool execBatch(bool arrayBind) override;
-	bool exec() override;
-	int size() override;
-	int numRowsAffected() override;
-	QVariant lastInsertId() const override;
-	QSqlRecord record() const override;
-	void detachFromResultSet() override;
+// sources of every connection, keyed by its client context as the table function is shared by the instance
+struct ScanSourceRegistry {
+	std::mutex mutex;
+	std::map<const duckdb::ClientContext *, std::map<std::string, std::shared_ptr<ScanSource>>> sources;
 };
 
-class QDuckDBDriverPrivate : public QSqlDriverPrivate {
-	Q_DECLARE_PUBLIC(QDuckDBDriver)
+static ScanSourceRegistry &scanSourceRegistry() {
+	static ScanSourceRegistry registry;
+	return registry;
+}
 
-public:
-	inline QDuckDBDriverPrivate() : QSqlDriverPrivate(QSqlDriver::UnknownDbms) {
+static bool qDropScanSource(const duckdb::ClientContext *context, const std::string &name) {
+	auto &registry = scanSourceRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	auto it = registry.sources.find(context);
+	if (it == registry.sources.end() || it->second.erase(name) == 0)
+		return false;
+	if (it->second.empty())
+		registry.sources.erase(it);
+	return true;
+}
+
+static void qDropScanSources(const duckdb::ClientContext *context) {
+	auto &registry = scanSourceRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	registry.sources.erase(context);
+}
+
+// fixed-width types of registerColumns()
+static duckdb::LogicalType qScanColumnType(const QString &name) {
+	static const std::map<QString, duckdb::LogicalType> types = {
+	    {"BOOLEAN"_L1, duckdb::LogicalType::BOOLEAN},   {"TINYINT"_L1, duckdb::LogicalType::TINYINT},
+	    {"SMALLINT"_L1, duckdb::LogicalType::SMALLINT}, {"INTEGER"_L1, duckdb::LogicalType::INTEGER},
+	    {"BIGINT"_L1, duckdb::LogicalType::BIGINT},     {"UTINYINT"_L1, duckdb::LogicalType::UTINYINT},
+	    {"USMALLINT"_L1, duckdb::LogicalType::USMALLINT}, {"UINTEGER"_L1, duckdb::LogicalType::UINTEGER},
+	    {"UBIGINT"_L1, duckdb::LogicalType::UBIGINT},   {"FLOAT"_L1, duckdb::LogicalType::FLOAT},
+	    {"DOUBLE"_L1, duckdb::LogicalType::DOUBLE}};
+	const auto it = types.find(name.toUpper());
+	return it == types.end() ? duckdb::LogicalType(duckdb::LogicalTypeId::INVALID) : it->second;
+}
+
+// column type of a model, from the value of its first row
+static duckdb::LogicalType qScanModelType(const QVariant &value) {
+	switch (value.userType()) {
+	case QMetaType::Bool:
+		return duckdb::LogicalType::BOOLEAN;
+	case QMetaType::Char:
+	case QMetaType::SChar:
+	case QMetaType::Short:
+	case QMetaType::Int:
+	case QMetaType::Long:
+	case QMetaType::LongLong:
+		return duckdb::LogicalType::BIGINT;
+	case QMetaType::UChar:
+	case QMetaType::UShort:
+	case QMetaType::UInt:
+	case QMetaType::ULong:
+	case QMetaType::ULongLong:
+		return duckdb::LogicalType::UBIGINT;
+	case QMetaType::Float:
+	case QMetaType::Double:
+		return duckdb::LogicalType::DOUBLE;
+	case QMetaType::QDate:
+		return duckdb::LogicalType::DATE;
+	case QMetaType::QDateTime:
+		return duckdb::LogicalType::TIMESTAMP;
+	case QMetaType::QByteArray:
+		return duckdb::LogicalType::BLOB;
+	default:
+		return duckdb::LogicalType::VARCHAR;
 	}
-	duckdb::unique_ptr<DbHandle> access = nullptr;
-	QList<QDuckDBResult *> results;
+}
+
+static void qSetScanValue(duckdb::Vector &vector, duckdb::idx_t row, const QVariant &value) {
+	if (value.isNull()) {
+		duckdb::FlatVector::SetNull(vector, row, true);
+		return;
+	}
+	switch (vector.GetType().id()) {
+	case duckdb::LogicalTypeId::BOOLEAN:
+		duckdb::FlatVector::GetData<bool>(vector)[row] = value.toBool();
+		break;
+	case duckdb::LogicalTypeId::BIGINT:
+		duckdb::FlatVector::GetData<int64_t>(vector)[row] = value.toLongLong();
+		break;
+	case duckdb::LogicalTypeId::UBIGINT:
+		duckdb::FlatVector::GetData<uint64_t>(vector)[row] = value.toULongLong();
+		break;
+	case duckdb::LogicalTypeId::DOUBLE:
+		duckdb::FlatVector::GetData<double>(vector)[row] = value.toDouble();
+		break;
+	case duckdb::LogicalTypeId::DATE: {
+		const QDate date = value.toDate();
+		duckdb::FlatVector::GetData<duckdb::date_t>(vector)[row] =
+		    duckdb::Date::FromDate(date.year(), date.month(), date.day());
+		break;
+	}
+	case duckdb::LogicalTypeId::TIMESTAMP: {
+		// the wall clock time, like TIMESTAMP values are read
+		const QDateTime dateTime = value.toDateTime();
+		const QDate date = dateTime.date();
+		const QTime time = dateTime.time();
+		duckdb::FlatVector::GetData<duckdb::timestamp_t>(vector)[row] = duckdb::Timestamp::FromDatetime(
+		    duckdb::Date::FromDate(date.year(), date.month(), date.day()),
+		    duckdb::Time::FromTime(time.hour(), time.minute(), time.second(), time.msec() * 1000));
+		break;
+	}
+	case duckdb::LogicalTypeId::BLOB: {
+		const QByteArray bytes = value.toByteArray();
+		duckdb::FlatVector::GetData<duckdb::string_t>(vector)[row] =
+		    duckdb::StringVector::AddStringOrBlob(vector, bytes.constData(), static_cast<duckdb::idx_t>(bytes.size()));
+		break;
+	}
+	default: {
+		const QByteArray text = value.toString().toUtf8();
+		duckdb::FlatVector::GetData<duckdb::string_t>(vector)[row] =
+		    duckdb::StringVector::AddString(vector, text.constData(), static_cast<duckdb::idx_t>(text.size()));
+		break;
+	}
+	}
+}
+
+struct ScanBindData : public duckdb::TableFunctionData {
+	std::string name;
+	std::shared_ptr<ScanSource> source;
+	duckdb::vector<duckdb::LogicalType> types;
 };
 
-class QDuckDBResultPrivate : public QSqlCachedResultPrivate {
-	Q_DECLARE_PUBLIC(QDuckDBResult)
+// a copied column of a model, scanned in step with the other columns of the statement
+struct ScanSnapshotColumn {
+	std::shared_ptr<duckdb::ColumnDataCollection> data;
+	duckdb::ColumnDataScanState scan;
+	duckdb::DataChunk chunk;
+};
 
-public:
-	Q_DECLARE_SQLDRIVER_PRIVATE(QDuckDBDriver)
-	using QSqlCachedResultPrivate::QSqlCachedResultPrivate;
-	void cleanup();
-	bool fetchNext(QSqlCachedResult::ValueCache &values, qsizetype idx, bool initialFetch);
-	// initializes the recordInfo and the cache
-	void initColumns(bool emptyResultset);
-	void finalize();
+struct ScanGlobalState : public duckdb::GlobalTableFunctionState {
+	duckdb::vector<duckdb::column_t> column_ids;
+	duckdb::idx_t offset = 0;
+	// rows of a model and its copied columns per entry of column_ids, nullptr for the row id
+	duckdb::idx_t rows = 0;
+	duckdb::vector<duckdb::unique_ptr<ScanSnapshotColumn>> snapshot;
 
-	std::unique_ptr<DuckDBStmt> stmt = nullptr;
-	QSqlRecord rInf;
-	QSqlCachedResult::ValueCache firstRow;
-	bool skippedStatus = false; // the status of the fetchNext() that's skipped
-	bool skipRow = false;       // skip the next fetchNext()?
+	// one thread keeps the rows in order
+	duckdb::idx_t MaxThreads() const override {
+		return 1;
+	}
 };
 
-void QDuckDBResultPrivate::cleanup() {
-	Q_Q(QDuckDBResult);
-	finalize();
-	rInf.clear();
-	skippedStatus = false;
-	skipRow = false;
-	q->setAt(QSql::BeforeFirstRow);
-	q->setActive(false);
-	q->cleanup();
+// copies the columns of the model of source a statement references. Models are thread-affine and may fetch rows in
+// data(), so they are only read on their thread before the statement executes, never by DuckDB's worker threads.
+static void qSnapshotModel(duckdb::ClientContext &context, ScanSource &source,
+                           const duckdb::vector<duckdb::LogicalType> &types,
+                           const std::set<duckdb::column_t> &columns) {
+	auto &model = *source.model;
+	while (model.canFetchMore(QModelIndex()))
+		model.fetchMore(QModelIndex());
+	const int rows = model.rowCount();
+	duckdb::vector<std::shared_ptr<duckdb::ColumnDataCollection>> snapshot(types.size());
+	for (const duckdb::column_t column : columns) {
+		if (column >= types.size())
+			continue;
+		const duckdb::vector<duckdb::LogicalType> columnTypes {types[column]};
+		auto data = std::make_shared<duckdb::ColumnDataCollection>(context, columnTypes);
+		duckdb::DataChunk chunk;
+		chunk.Initialize(context, columnTypes);
+		for (int offset = 0; offset < rows; offset += static_cast<int>(STANDARD_VECTOR_SIZE)) {
+			chunk.Reset();
+			const int count = qMin(static_cast<int>(STANDARD_VECTOR_SIZE), rows - offset);
+			for (int row = 0; row < count; ++row)
+				qSetScanValue(chunk.data[0], static_cast<duckdb::idx_t>(row),
+				              model.data(model.index(offset + row, static_cast<int>(column)), Qt::EditRole));
+			chunk.SetCardinality(static_cast<duckdb::idx_t>(count));
+			data->Append(chunk);
+		}
+		snapshot[column] = std::move(data);
+	}
+	std::lock_guard<std::mutex> lock(source.snapshotMutex);
+	source.snapshotRows = static_cast<duckdb::idx_t>(rows);
+	source.snapshot = std::move(snapshot);
 }
 
-void QDuckDBResultPrivate::finalize() {
-	if (!stmt)
-		return;
+static duckdb::unique_ptr<duckdb::FunctionData> qScanBind(duckdb::ClientContext &context,
+                                                          duckdb::TableFunctionBindInput &input,
+                                                          duckdb::vector<duckdb::LogicalType> &return_types,
+                                                          duckdb::vector<std::string> &names) {
+	const std::string name = input.inputs[0].GetValue<std::string>();
+	auto result = duckdb::make_uniq<ScanBindData>();
+	{
+		auto &registry = scanSourceRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		const auto sources = registry.sources.find(&context);
+		if (sources != registry.sources.end()) {
+			const auto source = sources->second.find(name);
+			if (source != sources->second.end())
+				result->source = source->second;
+		}
+	}
+	if (!result->source)
+		throw duckdb::BinderException("No model or columns are registered as \"%s\" on this connection", name);
+
+	// the header and the first row are read on the thread preparing the statement, the rows before each execution
+	if (auto *model = result->source->model.data()) {
+		if (model->thread() != QThread::currentThread())
+			throw duckdb::BinderException("The model registered as \"%s\" can only be queried on its thread", name);
+		const bool hasRows = model->rowCount() > 0;
+		for (int column = 0; column < model->columnCount(); ++column) {
+			QString header = model->headerData(column, Qt::Horizontal, Qt::DisplayRole).toString();
+			if (header.isEmpty())
+				header = "column"_L1 + QString::number(column);
+			names.push_back(header.toStdString());
+			return_types.push_back(hasRows ? qScanModelType(model->index(0, column).data(Qt::EditRole))
+			                               : duckdb::LogicalType::VARCHAR);
+		}
+	} else if (!result->source->columns.empty()) {
+		for (const auto &column : result->source->columns) {
+			names.push_back(column.name);
+			return_types.push_back(column.type);
+		}
+	}
+	if (names.empty())
+		throw duckdb::BinderException("The model registered as \"%s\" has no columns or was destroyed", name);
+	result->name = name;
+	result->types = return_types;
+	return std::move(result);
+}
 
-	stmt.reset();
+static duckdb::unique_ptr<duckdb::GlobalTableFunctionState> qScanInit(duckdb::ClientContext &context,
+                                                                      duckdb::TableFunctionInitInput &input) {
+	auto &bind = input.bind_data->Cast<ScanBindData>();
+	auto state = duckdb::make_uniq<ScanGlobalState>();
+	state->column_ids = input.column_ids;
+	auto &source = *bind.source;
+	if (!source.model)
+		return std::move(state);
+
+	std::unique_lock<std::mutex> lock(source.snapshotMutex);
+	const auto copied = [&](duckdb::column_t column) {
+		return column >= bind.types.size() || (column < source.snapshot.size() && source.snapshot[column]);
+	};
+	if (!std::all_of(state->column_ids.begin(), state->column_ids.end(), copied)) {
+		// not copied before the execution, e.g. as the statement was bound again with other columns
+		if (source.model->thread() != QThread::currentThread())
+			throw duckdb::InvalidInputException("The model registered as \"%s\" was not read for this statement",
+			                                    bind.name);
+		lock.unlock();
+		qSnapshotModel(context, source, bind.types,
+		               std::set<duckdb::column_t>(state->column_ids.begin(), state->column_ids.end()));
+		lock.lock();
+	}
+	state->rows = source.snapshotRows;
+	for (const duckdb::column_t column : state->column_ids) {
+		if (column >= bind.types.size()) {
+			state->snapshot.push_back(nullptr);
+			continue;
+		}
+		auto snapshotColumn = duckdb::make_uniq<ScanSnapshotColumn>();
+		snapshotColumn->data = source.snapshot[column];
+		snapshotColumn->data->InitializeScan(snapshotColumn->scan);
+		snapshotColumn->chunk.Initialize(context, {bind.types[column]});
+		state->snapshot.push_back(std::move(snapshotColumn));
+	}
+	return std::move(state);
 }
 
-void QDuckDBResultPrivate::initColumns(bool /*emptyResultset*/) {
-	Q_Q(QDuckDBResult);
-	if (!stmt || !stmt->prepared)
+// fills the next chunk with the projected columns only
+static void qScanFunction(duckdb::ClientContext &, duckdb::TableFunctionInput &input, duckdb::DataChunk &output) {
+	auto &bind = input.bind_data->Cast<ScanBindData>();
+	auto &state = input.global_state->Cast<ScanGlobalState>();
+	const auto &source = *bind.source;
+	const duckdb::idx_t rows = source.model ? state.rows : source.rows;
+	duckdb::idx_t count = 0;
+	if (state.offset < rows)
+		count = std::min<duckdb::idx_t>(STANDARD_VECTOR_SIZE, rows - state.offset);
+	if (count == 0) {
+		output.SetCardinality(0);
 		return;
+	}
+	for (duckdb::idx_t i = 0; i < state.column_ids.size(); ++i) {
+		const duckdb::column_t column = state.column_ids[i];
+		auto &vector = output.data[i];
+		if (column >= bind.types.size()) {
+			// row id
+			if (vector.GetType().id() == duckdb::LogicalTypeId::BIGINT) {
+				auto *data = duckdb::FlatVector::GetData<int64_t>(vector);
+				for (duckdb::idx_t row = 0; row < count; ++row)
+					data[row] = static_cast<int64_t>(state.offset + row);
+			} else {
+				vector.SetVectorType(duckdb::VectorType::CONSTANT_VECTOR);
+				duckdb::ConstantVector::SetNull(vector, true);
+			}
+		} else if (source.model) {
+			// the copies hold chunks of STANDARD_VECTOR_SIZE rows, like the ones scanned here
+			auto &snapshotColumn = *state.snapshot[i];
+			snapshotColumn.data->Scan(snapshotColumn.scan, snapshotColumn.chunk);
+			vector.Reference(snapshotColumn.chunk.data[0]);
+		} else {
+			const auto &scanColumn = source.columns[column];
+			const auto width = static_cast<qlonglong>(duckdb::GetTypeIdSize(scanColumn.type.InternalType()));
+			const char *first = scanColumn.data + static_cast<qlonglong>(state.offset) * scanColumn.stride;
+			if (scanColumn.stride == width) {
+				// contiguous values are referenced, not copied
+				duckdb::FlatVector::SetData(vector, reinterpret_cast<duckdb::data_ptr_t>(const_cast<char *>(first)));
+			} else {
+				auto *data = duckdb::FlatVector::GetData(vector);
+				for (duckdb::idx_t row = 0; row < count; ++row)
+					std::memcpy(data + row * static_cast<duckdb::idx_t>(width),
+					            first + static_cast<qlonglong>(row) * scanColumn.stride,
+					            static_cast<size_t>(width));
+			}
+		}
+	}
+	state.offset += count;
+	output.SetCardinality(count);
+}
 
-	duckdb::idx_t nCols = stmt->prepared->ColumnCount();
-	if (nCols <= 0)
+// qt_source(name) of the instance, registered once in its system catalog
+static void qRegisterScanFunction(duckdb::Connection &con) {
+	auto &instance = duckdb::DatabaseInstance::GetDatabase(*con.context);
+	duckdb::TableFunction function("qt_source", {duckdb::LogicalType::VARCHAR}, qScanFunction, qScanBind, qScanInit);
+	function.projection_pushdown = true;
+	duckdb::CreateTableFunctionInfo info(std::move(function));
+	info.on_conflict = duckdb::OnCreateConflict::IGNORE_ON_CONFLICT;
+	auto transaction = duckdb::CatalogTransaction::GetSystemTransaction(instance);
+	duckdb::Catalog::GetSystemCatalog(instance).CreateTableFunction(transaction, info);
+}
+
+// copies the models the plan of prepared scans, only the columns it references. Called on the thread executing the
+// statement right before each execution, which must be the thread of the models.
+static void qSnapshotScanSources(duckdb::ClientContext &context, const duckdb::PreparedStatement &prepared) {
+	if (!prepared.data || !prepared.data->physical_plan)
 		return;
+	std::map<ScanSource *, std::pair<const ScanBindData *, std::set<duckdb::column_t>>> models;
+	std::function<void(const duckdb::PhysicalOperator &)> collect = [&](const duckdb::PhysicalOperator &op) {
+		if (op.type == duckdb::PhysicalOperatorType::TABLE_SCAN) {
+			const auto &scan = op.Cast<duckdb::PhysicalTableScan>();
+			if (scan.function.function == qScanFunction && scan.bind_data) {
+				const auto &bind = scan.bind_data->Cast<ScanBindData>();
+				if (bind.source->model) {
+					auto &entry = models[bind.source.get()];
+					entry.first = &bind;
+					for (const auto &column : scan.column_ids)
+						entry.second.insert(column.GetPrimaryIndex());
+				}
+			}
+		}
+		for (const auto &child : op.GetChildren())
+			collect(child.get());
+	};
+	collect(prepared.data->physical_plan->Root());
+	for (auto &entry : models) {
+		const ScanBindData &bind = *entry.second.first;
+		if (!bind.source->model)
+			continue;
+		if (bind.source->model->thread() != QThread::currentThread())
+			throw duckdb::InvalidInputException("The model registered as \"%s\" can only be queried on its thread",
+			                                    bind.name);
+		qSnapshotModel(context, *entry.first, bind.types, entry.second.second);
+	}
+}
 
-	assert(nCols <= std::numeric_limits<int>::max());
-	q->init(static_cast<int>(nCols));
+// bytes written by DuckDB's COPY writers, queued for the QIODevice. The device is only written by the thread which
+// called exportToDevice(), DuckDB's threads wait while the queue is full.
+struct DeviceSink {
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::deque<QByteArray> chunks;
+	qint64 queued = 0;
+	// the statement returned
+	bool finished = false;
+	// the device failed, further writes throw
+	bool failed = false;
+	QString deviceError;
+	// progress of the statement, read by its own thread between two tasks
+	double percentage = -1;
+	quint64 rowsProcessed = 0;
+	quint64 totalRowsToProcess = 0;
+};
 
-	const auto &columnNamesVec = stmt->prepared->GetNames();
-	const auto &columnTypesVec = stmt->prepared->GetTypes();
+// bytes queued for a device before DuckDB's writers wait, and the limit of QIODevice::bytesToWrite()
+static constexpr qint64 DEVICE_QUEUE_BYTES = 8 * 1024 * 1024;
+static constexpr const char *DEVICE_PATH_PREFIX = "qtdevice://";
 
-	for (duckdb::idx_t i = 0; i < nCols; ++i) {
-		QString colName = QString::fromStdString(columnNamesVec[i]).remove(u'"');
-		auto fieldType = duckdbTypeToQtType(columnTypesVec[i]);
+static std::mutex deviceSinksMutex;
+static std::map<std::string, std::shared_ptr<DeviceSink>> deviceSinks;
 
-		QSqlField fld(colName, toQtType(fieldType));
-		rInf.append(fld);
-	}
-}
+class DeviceFileHandle : public duckdb::FileHandle {
+public:
+	DeviceFileHandle(duckdb::FileSystem &fs, const std::string &path, duckdb::FileOpenFlags flags,
+	                 std::shared_ptr<DeviceSink> sink)
+	    : duckdb::FileHandle(fs, path, flags), sink(std::move(sink)) {}
+	void Close() override {}
 
-///////////////////////
+	std::shared_ptr<DeviceSink> sink;
+	duckdb::idx_t written = 0;
+};
 
-bool QDuckDBResultPrivate::fetchNext(QSqlCachedResult::ValueCache &valuesCache, qsizetype in_idx, bool initialFetch) {
-	Q_Q(QDuckDBResult);
+// write-only file system for the paths qtdevice://<id>/<name> of exportToDevice(), registered once per instance
+class DeviceFileSystem : public duckdb::FileSystem {
+public:
+	duckdb::unique_ptr<duckdb::FileHandle> OpenFile(const std::string &path, duckdb::FileOpenFlags flags,
+	                                                duckdb::optional_ptr<duckdb::FileOpener> = nullptr) override {
+		if (flags.OpenForReading())
+			throw duckdb::IOException("\"%s\" can only be written", path);
+		const auto end = path.find('/', std::strlen(DEVICE_PATH_PREFIX));
+		std::lock_guard<std::mutex> lock(deviceSinksMutex);
+		const auto found = deviceSinks.find(path.substr(0, end));
+		if (found == deviceSinks.end())
+			throw duckdb::IOException("No device is exported to \"%s\"", path);
+		return duckdb::make_uniq<DeviceFileHandle>(*this, path, flags, found->second);
+	}
 
-	if (skipRow) {
-		// already fetched
-		Q_ASSERT(!initialFetch);
-		skipRow = false;
-		for (qsizetype i = 0; i < firstRow.size(); i++)
-			valuesCache[i] = firstRow[i];
-		return skippedStatus;
+	void Write(duckdb::FileHandle &handle, void *buffer, int64_t nr_bytes, duckdb::idx_t location) override {
+		if (location != handle.Cast<DeviceFileHandle>().written)
+			throw duckdb::IOException("\"%s\" can only be written sequentially", handle.path);
+		Write(handle, buffer, nr_bytes);
 	}
-	skipRow = initialFetch;
 
-	if (initialFetch) {
-		firstRow.clear();
-		if (stmt && stmt->prepared)
-			firstRow.resize(static_cast<qsizetype>(stmt->prepared->ColumnCount()));
+	int64_t Write(duckdb::FileHandle &handle, void *buffer, int64_t nr_bytes) override {
+		auto &device = handle.Cast<DeviceFileHandle>();
+		auto &sink = *device.sink;
+		std::unique_lock<std::mutex> lock(sink.mutex);
+		sink.changed.wait(lock, [&sink] { return sink.failed || sink.queued < DEVICE_QUEUE_BYTES; });
+		if (sink.failed)
+			throw duckdb::IOException("Writing to the device failed: %s", sink.deviceError.toStdString());
+		sink.chunks.emplace_back(static_cast<const char *>(buffer), static_cast<int>(nr_bytes));
+		sink.queued += nr_bytes;
+		device.written += static_cast<duckdb::idx_t>(nr_bytes);
+		sink.changed.notify_all();
+		return nr_bytes;
 	}
 
-	if (!stmt || !stmt->context) {
-		q->setLastError(QSqlError(QCoreApplication::translate("QDuckDbResult", "Unable to fetch row"),
-		                          QCoreApplication::translate("QDuckDbResult", "No query"),
-		                          QSqlError::ConnectionError));
-		q->setAt(QSql::AfterLastRow);
+	int64_t GetFileSize(duckdb::FileHandle &handle) override {
+		return static_cast<int64_t>(handle.Cast<DeviceFileHandle>().written);
+	}
+	void FileSync(duckdb::FileHandle &) override {}
+	// COPY writes to a temporary file first and renames it if the target exists, a device never does
+	bool FileExists(const std::string &, duckdb::optional_ptr<duckdb::FileOpener> = nullptr) override {
 		return false;
 	}
-	if (!stmt->prepared) {
-		q->setLastError(
-		    QSqlError(QCoreApplication::translate("QDuckDbResult", "Unable to fetch row"),
-		              QCoreApplication::translate("QDuckDbResult",
-		                                          "Attempting fetchNext() on a non-successfully prepared statement."),
-		              QSqlError::ConnectionError));
-		q->setAt(QSql::AfterLastRow);
+	void RemoveFile(const std::string &, duckdb::optional_ptr<duckdb::FileOpener> = nullptr) override {}
+	bool CanSeek() override {
 		return false;
 	}
+	bool OnDiskFile(duckdb::FileHandle &) override {
+		return false;
+	}
+	bool CanHandleFile(const std::string &path) override {
+		return path.rfind(DEVICE_PATH_PREFIX, 0) == 0;
+	}
+	std::string GetName() const override {
+		return "QtDeviceFileSystem";
+	}
+};
 
-	auto buildError = [this, q](duckdb::ErrorData &errData) {
-		auto sqlError = qMakeError(errData, "Unable to fetch row.", QSqlError::ConnectionError);
-		stmt->result.reset();
-		stmt->current_chunk.reset();
-		q->setLastError(sqlError);
-		q->setAt(QSql::AfterLastRow);
-	};
-
-	auto fetchNext = [&]() {
-		duckdb::ErrorData errData;
-		if (!stmt->result->TryFetch(stmt->current_chunk, errData)) {
-			buildError(errData);
-			return false;
+// named buffers of every connection, keyed by its client context like the sources of qt_source()
+static std::mutex bufferRegistryMutex;
+static std::map<const duckdb::ClientContext *, std::map<std::string, QByteArray>> bufferRegistry;
+
+static bool qDropBuffer(const duckdb::ClientContext *context, const std::string &name) {
+	std::lock_guard<std::mutex> lock(bufferRegistryMutex);
+	auto it = bufferRegistry.find(context);
+	if (it == bufferRegistry.end() || it->second.erase(name) == 0)
+		return false;
+	if (it->second.empty())
+		bufferRegistry.erase(it);
+	return true;
+}
+
+static void qDropBuffers(const duckdb::ClientContext *context) {
+	std::lock_guard<std::mutex> lock(bufferRegistryMutex);
+	bufferRegistry.erase(context);
+}
+
+static constexpr const char *BUFFER_PATH_PREFIX = "qtbuffer://";
+
+// bytes of a Qt resource or a named buffer. Uncompressed resources are read where they are mapped,
+// buffers through a shallow copy of their QByteArray.
+class MemoryFileHandle : public duckdb::FileHandle {
+public:
+	MemoryFileHandle(duckdb::FileSystem &fs, const std::string &path, duckdb::FileOpenFlags flags, QByteArray bytes,
+	                 const char *first, duckdb::idx_t length)
+	    : duckdb::FileHandle(fs, path, flags), owner(std::move(bytes)), data(first), size(length) {}
+	void Close() override {}
+
+	QByteArray owner;
+	const char *data;
+	duckdb::idx_t size;
+	duckdb::idx_t position = 0;
+};
+
+// read-only file system for Qt resources (":/data/x.csv" or "qrc:/data/x.csv") and the buffers of registerBuffer()
+// ("qtbuffer://name"), registered on every instance
+class ResourceFileSystem : public duckdb::FileSystem {
+public:
+	duckdb::unique_ptr<duckdb::FileHandle> OpenFile(const std::string &path, duckdb::FileOpenFlags flags,
+	                                                duckdb::optional_ptr<duckdb::FileOpener> opener) override {
+		if (flags.OpenForWriting())
+			throw duckdb::IOException("\"%s\" can only be read", path);
+		QByteArray owner;
+		const char *data = nullptr;
+		duckdb::idx_t size = 0;
+		if (!resolve(path, opener, owner, data, size)) {
+			if (flags.ReturnNullIfNotExists())
+				return nullptr;
+			throw duckdb::IOException("No such resource or buffer: \"%s\"", path);
 		}
+		return duckdb::make_uniq<MemoryFileHandle>(*this, path, flags, std::move(owner), data, size);
+	}
+
+	void Read(duckdb::FileHandle &handle, void *buffer, int64_t nr_bytes, duckdb::idx_t location) override {
+		auto &file = handle.Cast<MemoryFileHandle>();
+		if (nr_bytes < 0 || location > file.size || static_cast<duckdb::idx_t>(nr_bytes) > file.size - location)
+			throw duckdb::IOException("Could not read %d bytes at %d from \"%s\"", nr_bytes, location, file.path);
+		std::memcpy(buffer, file.data + location, static_cast<size_t>(nr_bytes));
+	}
+
+	int64_t Read(duckdb::FileHandle &handle, void *buffer, int64_t nr_bytes) override {
+		auto &file = handle.Cast<MemoryFileHandle>();
+		const auto count = std::min(static_cast<duckdb::idx_t>(std::max<int64_t>(nr_bytes, 0)),
+		                            file.size - std::min(file.position, file.size));
+		std::memcpy(buffer, file.data + file.position, static_cast<size_t>(count));
+		file.position += count;
+		return static_cast<int64_t>(count);
+	}
+
+	int64_t GetFileSize(duckdb::FileHandle &handle) override {
+		return static_cast<int64_t>(handle.Cast<MemoryFileHandle>().size);
+	}
+	void Seek(duckdb::FileHandle &handle, duckdb::idx_t location) override {
+		handle.Cast<MemoryFileHandle>().position = location;
+	}
+	void Reset(duckdb::FileHandle &handle) override {
+		handle.Cast<MemoryFileHandle>().position = 0;
+	}
+	duckdb::idx_t SeekPosition(duckdb::FileHandle &handle) override {
+		return handle.Cast<MemoryFileHandle>().position;
+	}
+	bool CanSeek() override {
 		return true;
-	};
+	}
+	// random reads are as cheap as for a local file, so readers need not prefetch
+	bool OnDiskFile(duckdb::FileHandle &) override {
+		return true;
+	}
 
-	auto isDone = [&]() {
-		if (!stmt->current_chunk || stmt->current_chunk->size() == 0) {
-			stmt->result = nullptr;
-			stmt->current_chunk = nullptr;
-			if (rInf.isEmpty())
-				initColumns(true);
-			q->setAt(QSql::AfterLastRow);
-			return true;
+	bool FileExists(const std::string &path, duckdb::optional_ptr<duckdb::FileOpener> opener = nullptr) override {
+		QByteArray owner;
+		const char *data = nullptr;
+		duckdb::idx_t size = 0;
+		return resolve(path, opener, owner, data, size);
+	}
+
+	// wildcards are supported in the file name of resources, e.g. ":/data/*.csv"
+	duckdb::vector<duckdb::OpenFileInfo> Glob(const std::string &path, duckdb::FileOpener *opener = nullptr) override {
+		duckdb::vector<duckdb::OpenFileInfo> files;
+		const QString resource = resourcePath(path);
+		const auto slash = resource.lastIndexOf(QLatin1Char('/'));
+		if (!resource.isEmpty() && slash >= 0 && resource.indexOf(QRegularExpression("[*?\\[]"_L1), slash) >= 0) {
+			QDir dir(resource.left(slash));
+			for (const auto &name : dir.entryList({resource.mid(slash + 1)}, QDir::Files, QDir::Name))
+				files.emplace_back(dir.filePath(name).toStdString());
+		} else if (FileExists(path, opener)) {
+			files.emplace_back(path);
 		}
-		return false;
-	};
+		return files;
+	}
 
-	auto executeQuery = [&]() {
-		stmt->result = stmt->prepared->Execute(stmt->bound_values, true);
-		if (stmt->result->HasError()) {
-			// error in execute: clear prepared statement
-			buildError(stmt->result->GetErrorObject());
+	bool CanHandleFile(const std::string &path) override {
+		return path.rfind(":/", 0) == 0 || path.rfind("qrc:", 0) == 0 || path.rfind(BUFFER_PATH_PREFIX, 0) == 0;
+	}
+	std::string GetName() const override {
+		return "QtResourceFileSystem";
+	}
+
+private:
+	// ":/data/x.csv" for the paths of resources, an empty string for others
+	static QString resourcePath(const std::string &path) {
+		QString resource = QString::fromStdString(path);
+		if (resource.startsWith("qrc:"_L1)) {
+			resource = resource.mid(4);
+			while (resource.startsWith("//"_L1))
+				resource.remove(0, 1);
+			return QLatin1Char(':') + resource;
+		}
+		return resource.startsWith(":/"_L1) ? resource : QString();
+	}
+
+	static bool resolve(const std::string &path, duckdb::optional_ptr<duckdb::FileOpener> opener, QByteArray &owner,
+	                    const char *&data, duckdb::idx_t &size) {
+		if (path.rfind(BUFFER_PATH_PREFIX, 0) == 0) {
+			// buffers are registered per connection, only queries know theirs
+			auto context = duckdb::FileOpener::TryGetClientContext(opener);
+			if (!context)
+				return false;
+			std::lock_guard<std::mutex> lock(bufferRegistryMutex);
+			const auto buffers = bufferRegistry.find(context.get());
+			if (buffers == bufferRegistry.end())
+				return false;
+			const auto found = buffers->second.find(path.substr(std::strlen(BUFFER_PATH_PREFIX)));
+			if (found == buffers->second.end())
+				return false;
+			owner = found->second;
+			data = owner.constData();
+			size = static_cast<duckdb::idx_t>(owner.size());
+			return true;
+		}
+		const QString name = resourcePath(path);
+		if (name.isEmpty() || !QFileInfo(name).isFile())
 			return false;
+		QResource resource(name);
+		if (resource.compressionAlgorithm() == QResource::NoCompression) {
+			data = reinterpret_cast<const char *>(resource.data());
+			size = static_cast<duckdb::idx_t>(resource.size());
+		} else {
+			owner = resource.uncompressedData();
+			data = owner.constData();
+			size = static_cast<duckdb::idx_t>(owner.size());
 		}
 		return true;
+	}
+};
+
+// registers the file systems of the driver, once per instance as shared instances are opened by several drivers
+static void qRegisterFileSystems(duckdb::DatabaseInstance &instance) {
+	static std::mutex registerMutex;
+	std::lock_guard<std::mutex> lock(registerMutex);
+	auto &fs = instance.GetFileSystem();
+	const auto names = fs.ListSubSystems();
+	const auto registered = [&names](const duckdb::FileSystem &sub) {
+		return std::find(names.begin(), names.end(), sub.GetName()) != names.end();
 	};
+	if (!registered(DeviceFileSystem()))
+		fs.RegisterSubSystem(duckdb::make_uniq<DeviceFileSystem>());
+	if (!registered(ResourceFileSystem()))
+		fs.RegisterSubSystem(duckdb::make_uniq<ResourceFileSystem>());
+}
 
-	auto collectStats = [&]() {
-		auto properties = stmt->prepared->GetStatementProperties();
-		if (properties.return_type == duckdb::StatementReturnType::CHANGED_ROWS && stmt->current_chunk &&
-		    stmt->current_chunk->size() > 0) {
-			// update total changes
-			auto row_changes = stmt->current_chunk->GetValue(0, 0);
-			if (!row_changes.IsNull() && row_changes.DefaultTryCastAs(duckdb::LogicalType::BIGINT)) {
-				stmt->last_changes = row_changes.GetValue<int64_t>();
-			}
+// Downsampling aggregates for plots, registered on every instance. lttb(x, y, n) picks n points by
+// Largest-Triangle-Three-Buckets, minmax_downsample(x, y, n) the first and last point and the points with the
+// smallest and largest y of n buckets of equal width along x. Both return LIST(STRUCT(x, y)) ordered by x,
+// rows with a NULL x or y are skipped.
+template <typename X>
+using PlotPoints = std::vector<std::pair<X, double>>;
+
+static double qPlotX(double x) {
+	return x;
+}
+
+static double qPlotX(int64_t x) {
+	return static_cast<double>(x);
+}
+
+// also TIMESTAMP WITH TIME ZONE
+static double qPlotX(duckdb::timestamp_t x) {
+	return static_cast<double>(x.value);
+}
+
+template <typename X>
+static PlotPoints<X> qLttb(const PlotPoints<X> &points, duckdb::idx_t threshold) {
+	const size_t count = points.size();
+	if (threshold >= count)
+		return points;
+	if (threshold < 3)
+		return {points.front(), points.back()};
+
+	PlotPoints<X> sampled;
+	sampled.reserve(threshold);
+	sampled.push_back(points.front());
+	// the first and the last point are kept, the others are split into threshold - 2 buckets
+	const double bucket = static_cast<double>(count - 2) / static_cast<double>(threshold - 2);
+	size_t previous = 0;
+	for (size_t i = 0; i + 2 < threshold; ++i) {
+		const size_t begin = static_cast<size_t>(static_cast<double>(i) * bucket) + 1;
+		const size_t end = std::min(static_cast<size_t>(static_cast<double>(i + 1) * bucket) + 1, count - 1);
+		const size_t nextEnd = std::min(static_cast<size_t>(static_cast<double>(i + 2) * bucket) + 1, count);
+
+		// the third corner of the triangles is the average of the next bucket
+		double averageX = 0;
+		double averageY = 0;
+		for (size_t j = end; j < nextEnd; ++j) {
+			averageX += qPlotX(points[j].first);
+			averageY += points[j].second;
 		}
-		if (properties.return_type != duckdb::StatementReturnType::QUERY_RESULT) {
-			stmt->current_chunk.reset();
-			stmt->result.reset();
+		const double nextCount = static_cast<double>(std::max<size_t>(nextEnd - end, 1));
+		averageX /= nextCount;
+		averageY /= nextCount;
+
+		const double previousX = qPlotX(points[previous].first);
+		const double previousY = points[previous].second;
+		size_t picked = begin;
+		double largestArea = -1;
+		for (size_t j = begin; j < end; ++j) {
+			const double area = std::abs((previousX - averageX) * (points[j].second - previousY) -
+			                             (previousX - qPlotX(points[j].first)) * (averageY - previousY));
+			if (area > largestArea) {
+				largestArea = area;
+				picked = j;
+			}
 		}
+		sampled.push_back(points[picked]);
+		previous = picked;
+	}
+	sampled.push_back(points.back());
+	return sampled;
+}
+
+template <typename X>
+static PlotPoints<X> qMinMaxDownsample(const PlotPoints<X> &points, duckdb::idx_t buckets) {
+	if (points.size() <= 2 * buckets + 2)
+		return points;
+	const double first = qPlotX(points.front().first);
+	const double width = (qPlotX(points.back().first) - first) / static_cast<double>(buckets);
+	const auto bucketOf = [&](size_t i) {
+		if (width <= 0)
+			return duckdb::idx_t(0);
+		return std::min(buckets - 1, static_cast<duckdb::idx_t>((qPlotX(points[i].first) - first) / width));
 	};
 
-	auto fillRow = [&]() {
-		assert(stmt->current_row.has_value());
-		//// check to see if should fill out columns
-		if (rInf.isEmpty())
-			// must be first call.
-			initColumns(false);
-		if (in_idx < 0 && !initialFetch)
-			return true;
-		const qsizetype rowCount = rInf.count();
-		for (qsizetype i = 0; i < rowCount; ++i) {
+	// the first and the last point keep the range of x
+	std::vector<size_t> picked {0};
+	for (size_t begin = 0; begin < points.size();) {
+		const auto bucket = bucketOf(begin);
+		size_t smallest = begin;
+		size_t largest = begin;
+		size_t end = begin + 1;
+		for (; end < points.size() && bucketOf(end) == bucket; ++end) {
+			if (points[end].second < points[smallest].second)
+				smallest = end;
+			if (points[end].second > points[largest].second)
+				largest = end;
+		}
+		picked.push_back(std::min(smallest, largest));
+		picked.push_back(std::max(smallest, largest));
+		begin = end;
+	}
+	picked.push_back(points.size() - 1);
+	picked.erase(std::unique(picked.begin(), picked.end()), picked.end());
+
+	PlotPoints<X> sampled;
+	sampled.reserve(picked.size());
+	for (const size_t i : picked)
+		sampled.push_back(points[i]);
+	return sampled;
+}
 
-			duckdb::Value val = stmt->current_chunk->data[static_cast<size_t>(i)].GetValue(*stmt->current_row);
-			if (val.IsNull()) {
-				valuesCache[i + in_idx] = QVariant();
-				continue;
-			}
-			switch (val.type().id()) {
-			case duckdb::LogicalTypeId::BLOB: {
-				val = val.CastAs(*stmt->context, duckdb::LogicalType::BLOB);
-				const auto &str = duckdb::StringValue::Get(val);
-				valuesCache[i + in_idx] = QByteArray(str.data(), static_cast<qsizetype>(str.size()));
-				break;
+struct PlotBindData : public duckdb::FunctionData {
+	explicit PlotBindData(duckdb::idx_t points) : points(points) {}
+	duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+		return duckdb::make_uniq<PlotBindData>(points);
+	}
+	bool Equals(const duckdb::FunctionData &other) const override {
+		return points == other.Cast<PlotBindData>().points;
+	}
+	duckdb::idx_t points;
+};
+
+// the number of points is a constant of the query, it is removed from the arguments
+static duckdb::unique_ptr<duckdb::FunctionData>
+qPlotBind(duckdb::ClientContext &context, duckdb::AggregateFunction &function,
+          duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> &arguments) {
+	if (!arguments[2]->IsFoldable())
+		throw duckdb::BinderException("The number of points of %s must be a constant", function.name);
+	const auto value = duckdb::ExpressionExecutor::EvaluateScalar(context, *arguments[2]);
+	if (value.IsNull() || value.GetValue<int64_t>() < 2)
+		throw duckdb::BinderException("%s needs at least 2 points", function.name);
+	const auto points = static_cast<duckdb::idx_t>(value.GetValue<int64_t>());
+	duckdb::Function::EraseArgument(function, arguments, 2);
+	return duckdb::make_uniq<PlotBindData>(points);
+}
+
+// the DuckDB state of a group points to its points, allocated by the first one
+static duckdb::idx_t qPlotStateSize(const duckdb::AggregateFunction &) {
+	return sizeof(void *);
+}
+
+static void qPlotInitialize(const duckdb::AggregateFunction &, duckdb::data_ptr_t state) {
+	*reinterpret_cast<void **>(state) = nullptr;
+}
+
+template <typename X>
+static PlotPoints<X> *&qPlotPoints(duckdb::data_ptr_t state) {
+	return *reinterpret_cast<PlotPoints<X> **>(state);
+}
+
+template <typename X>
+static void qPlotUpdate(duckdb::Vector inputs[], duckdb::AggregateInputData &, duckdb::idx_t, duckdb::Vector &states,
+                        duckdb::idx_t count) {
+	duckdb::UnifiedVectorFormat xs, ys, stateFormat;
+	inputs[0].ToUnifiedFormat(count, xs);
+	inputs[1].ToUnifiedFormat(count, ys);
+	states.ToUnifiedFormat(count, stateFormat);
+	const auto xData = duckdb::UnifiedVectorFormat::GetData<X>(xs);
+	const auto yData = duckdb::UnifiedVectorFormat::GetData<double>(ys);
+	// ungrouped aggregates pass a constant vector of their only state
+	const auto statePointers = duckdb::UnifiedVectorFormat::GetData<duckdb::data_ptr_t>(stateFormat);
+	for (duckdb::idx_t row = 0; row < count; ++row) {
+		const auto x = xs.sel->get_index(row);
+		const auto y = ys.sel->get_index(row);
+		if (!xs.validity.RowIsValid(x) || !ys.validity.RowIsValid(y))
+			continue;
+		auto &points = qPlotPoints<X>(statePointers[stateFormat.sel->get_index(row)]);
+		if (!points)
+			points = new PlotPoints<X>();
+		points->emplace_back(xData[x], yData[y]);
+	}
+}
+
+template <typename X>
+static void qPlotCombine(duckdb::Vector &source, duckdb::Vector &target, duckdb::AggregateInputData &,
+                         duckdb::idx_t count) {
+	duckdb::UnifiedVectorFormat sourceFormat;
+	source.ToUnifiedFormat(count, sourceFormat);
+	const auto sources = duckdb::UnifiedVectorFormat::GetData<duckdb::data_ptr_t>(sourceFormat);
+	const auto targets = duckdb::FlatVector::GetData<duckdb::data_ptr_t>(target);
+	for (duckdb::idx_t i = 0; i < count; ++i) {
+		const auto *points = qPlotPoints<X>(sources[sourceFormat.sel->get_index(i)]);
+		if (!points)
+			continue;
+		auto &combined = qPlotPoints<X>(targets[i]);
+		if (!combined)
+			combined = new PlotPoints<X>();
+		combined->insert(combined->end(), points->begin(), points->end());
+	}
+}
+
+// appends the points picked from the points of state to the child of result and points entry to them
+template <typename X, PlotPoints<X> (*Pick)(const PlotPoints<X> &, duckdb::idx_t)>
+static void qPlotPick(duckdb::data_ptr_t state, duckdb::idx_t threshold, duckdb::Vector &result,
+                      duckdb::list_entry_t &entry) {
+	PlotPoints<X> picked;
+	if (auto *points = qPlotPoints<X>(state)) {
+		std::stable_sort(points->begin(), points->end(),
+		                 [](const auto &a, const auto &b) { return qPlotX(a.first) < qPlotX(b.first); });
+		picked = Pick(*points, threshold);
+	}
+	const auto offset = duckdb::ListVector::GetListSize(result);
+	duckdb::ListVector::Reserve(result, offset + picked.size());
+	auto &fields = duckdb::StructVector::GetEntries(duckdb::ListVector::GetEntry(result));
+	auto xs = duckdb::FlatVector::GetData<X>(*fields[0]);
+	auto ys = duckdb::FlatVector::GetData<double>(*fields[1]);
+	for (size_t i = 0; i < picked.size(); ++i) {
+		xs[offset + i] = picked[i].first;
+		ys[offset + i] = picked[i].second;
+	}
+	entry.offset = offset;
+	entry.length = picked.size();
+	duckdb::ListVector::SetListSize(result, offset + picked.size());
+}
+
+template <typename X, PlotPoints<X> (*Pick)(const PlotPoints<X> &, duckdb::idx_t)>
+static void qPlotFinalize(duckdb::Vector &states, duckdb::AggregateInputData &input, duckdb::Vector &result,
+                          duckdb::idx_t count, duckdb::idx_t offset) {
+	const auto threshold = input.bind_data->Cast<PlotBindData>().points;
+	if (states.GetVectorType() == duckdb::VectorType::CONSTANT_VECTOR) {
+		result.SetVectorType(duckdb::VectorType::CONSTANT_VECTOR);
+		qPlotPick<X, Pick>(*duckdb::ConstantVector::GetData<duckdb::data_ptr_t>(states), threshold, result,
+		                   *duckdb::ConstantVector::GetData<duckdb::list_entry_t>(result));
+		return;
+	}
+	result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+	const auto statePointers = duckdb::FlatVector::GetData<duckdb::data_ptr_t>(states);
+	const auto entries = duckdb::FlatVector::GetData<duckdb::list_entry_t>(result);
+	for (duckdb::idx_t i = 0; i < count; ++i)
+		qPlotPick<X, Pick>(statePointers[i], threshold, result, entries[i + offset]);
+}
+
+template <typename X>
+static void qPlotDestroy(duckdb::Vector &states, duckdb::AggregateInputData &, duckdb::idx_t count) {
+	const auto statePointers = duckdb::FlatVector::GetData<duckdb::data_ptr_t>(states);
+	for (duckdb::idx_t i = 0; i < count; ++i) {
+		auto &points = qPlotPoints<X>(statePointers[i]);
+		delete points;
+		points = nullptr;
+	}
+}
+
+template <typename X, PlotPoints<X> (*Pick)(const PlotPoints<X> &, duckdb::idx_t)>
+static duckdb::AggregateFunction qPlotFunction(const std::string &name, const duckdb::LogicalType &xType) {
+	duckdb::child_list_t<duckdb::LogicalType> point {{"x", xType}, {"y", duckdb::LogicalType::DOUBLE}};
+	return duckdb::AggregateFunction(name, {xType, duckdb::LogicalType::DOUBLE, duckdb::LogicalType::BIGINT},
+	                                 duckdb::LogicalType::LIST(duckdb::LogicalType::STRUCT(std::move(point))),
+	                                 qPlotStateSize, qPlotInitialize, qPlotUpdate<X>, qPlotCombine<X>,
+	                                 qPlotFinalize<X, Pick>, duckdb::FunctionNullHandling::DEFAULT_NULL_HANDLING,
+	                                 nullptr, qPlotBind, qPlotDestroy<X>);
+}
+
+template <template <typename> class Pick>
+static duckdb::AggregateFunctionSet qPlotFunctionSet(const std::string &name) {
+	duckdb::AggregateFunctionSet set(name);
+	set.AddFunction(qPlotFunction<double, Pick<double>::pick>(name, duckdb::LogicalType::DOUBLE));
+	set.AddFunction(qPlotFunction<int64_t, Pick<int64_t>::pick>(name, duckdb::LogicalType::BIGINT));
+	set.AddFunction(qPlotFunction<duckdb::timestamp_t, Pick<duckdb::timestamp_t>::pick>(
+	    name, duckdb::LogicalType::TIMESTAMP));
+	set.AddFunction(qPlotFunction<duckdb::timestamp_tz_t, Pick<duckdb::timestamp_tz_t>::pick>(
+	    name, duckdb::LogicalType::TIMESTAMP_TZ));
+	return set;
+}
+
+template <typename X>
+struct LttbPick {
+	static constexpr auto pick = qLttb<X>;
+};
+
+template <typename X>
+struct MinMaxPick {
+	static constexpr auto pick = qMinMaxDownsample<X>;
+};
+
+static void qRegisterPlotFunctions(duckdb::DatabaseInstance &instance) {
+	auto transaction = duckdb::CatalogTransaction::GetSystemTransaction(instance);
+	auto &catalog = duckdb::Catalog::GetSystemCatalog(instance);
+	for (auto set : {qPlotFunctionSet<LttbPick>("lttb"), qPlotFunctionSet<MinMaxPick>("minmax_downsample")}) {
+		duckdb::CreateAggregateFunctionInfo info(std::move(set));
+		info.on_conflict = duckdb::OnCreateConflict::IGNORE_ON_CONFLICT;
+		catalog.CreateFunction(transaction, info);
+	}
+}
+
+class QDuckDBResultPrivate;
+
+class QDuckDBResult : public QSqlCachedResult {
+	Q_DECLARE_PRIVATE(QDuckDBResult)
+	friend class QDuckDBDriver;
+
+public:
+	explicit QDuckDBResult(const QDuckDBDriver *db);
+	~QDuckDBResult();
+
+protected:
+	bool gotoNext(QSqlCachedResult::ValueCache &row, int idx) override;
+	bool reset(const QString &query) override;
+	bool prepare(const QString &query) override;
+	bool execBatch(bool arrayBind) override;
+	bool exec() override;
+	int size() override;
+	int numRowsAffected() override;
+	QVariant lastInsertId() const override;
+	QSqlRecord record() const override;
+	void detachFromResultSet() override;
+	// returns a DuckDBResultHandle
+	QVariant handle() const override;
+};
+
+class QDuckDBDriverPrivate : public QSqlDriverPrivate {
+	Q_DECLARE_PUBLIC(QDuckDBDriver)
+
+public:
+	inline QDuckDBDriverPrivate() : QSqlDriverPrivate(QSqlDriver::UnknownDbms) {
+	}
+	// creates the instance and the connection
+	bool openInstance(QSqlError &error);
+	// opens the instance if it was deferred by LAZY_OPEN and loads the deferred extensions
+	bool ensureAccess(QSqlError &error);
+
+	duckdb::unique_ptr<DbHandle> access = nullptr;
+	// guards access against close() while cancelQuery() is called from another thread
+	std::mutex accessMutex;
+	QList<QDuckDBResult *> results;
+	QString databaseName;
+	ConnectOptions options;
+	bool deferredExtensionsLoaded = false;
+
+	// results of record(), primaryIndex() and tables(), cleared by statements which may change the schema
+	QHash<QString, QSqlRecord> recordCache;
+	QHash<QString, QSqlIndex> primaryIndexCache;
+	QHash<int, QStringList> tablesCache;
+	// counts the schema changes, statements prepared before the last one are not reused by prepare()
+	quint64 schemaGeneration = 0;
+	// asked between the tasks of a statement whether to interrupt it, see setInterruptCheck()
+	std::function<bool()> interruptCheck;
+	void invalidateMetadataCache() {
+		recordCache.clear();
+		primaryIndexCache.clear();
+		tablesCache.clear();
+		++schemaGeneration;
+	}
+
+	// adds source to the sources of qt_source() of the connection and creates its view
+	bool registerScanSource(const QString &name, std::shared_ptr<ScanSource> source, QSqlError &error);
+
+	// streams scanned by the views of registerArrowStream(), released after their view is gone
+	QHash<QString, std::shared_ptr<ArrowArrayStream>> arrowStreams;
+	int arrowIngestCount = 0;
+};
+
+bool QDuckDBDriverPrivate::openInstance(QSqlError &error) {
+	try {
+		auto access = duckdb::make_uniq<DbHandle>();
+		duckdb::DBConfig config;
+		config.options.access_mode = duckdb::AccessMode::AUTOMATIC;
+		if (options.readOnly) {
+			config.options.access_mode = duckdb::AccessMode::READ_ONLY;
+		}
+		for (const auto &setting : options.settings) {
+			config.SetOptionByName(setting.first, duckdb::Value(setting.second));
+		}
+		config.AddExtensionOption(QUERY_TIMEOUT_SETTING,
+		                          "Timeout in milliseconds of statements executed by the Qt driver, 0 disables it",
+		                          duckdb::LogicalType::UBIGINT);
+		if (!options.deferredExtensions.isEmpty()) {
+			// the driver loads the linked extensions itself, so that it can skip the deferred ones
+			config.options.load_extensions = false;
+		}
+		if (options.sharedInstance) {
+			// every driver (e.g. the per-thread clones of one QSqlDatabase) gets its own Connection
+			// to the instance which was opened first
+			access->db = sharedInstanceCache().GetOrCreateInstance(databaseName.toStdString(), config, true);
+		} else {
+			access->db = duckdb::make_shared_ptr<duckdb::DuckDB>(databaseName.toStdString(), &config);
+		}
+		if (!options.deferredExtensions.isEmpty()) {
+			for (const auto &extension : qLinkedExtensions()) {
+				if (!options.deferredExtensions.contains(extension))
+					qLoadLinkedExtension(*access->db, extension);
 			}
-			case duckdb::LogicalTypeId::BOOLEAN:
-			case duckdb::LogicalTypeId::TINYINT:
-			case duckdb::LogicalTypeId::SMALLINT:
-			case duckdb::LogicalTypeId::INTEGER:
-			case duckdb::LogicalTypeId::BIGINT:
-				val = val.CastAs(*stmt->context, duckdb::LogicalType::BIGINT);
-				valuesCache[i + in_idx] = qint64 {duckdb::BigIntValue::Get(val)};
-				break;
-			case duckdb::LogicalTypeId::UTINYINT:
-			case duckdb::LogicalTypeId::USMALLINT:
-			case duckdb::LogicalTypeId::UINTEGER:
-			case duckdb::LogicalTypeId::UBIGINT:
-				val = val.CastAs(*stmt->context, duckdb::LogicalType::UBIGINT);
-				valuesCache[i + in_idx] = quint64 {duckdb::UBigIntValue::Get(val)};
-				break;
-			case duckdb::LogicalTypeId::FLOAT:
-			case duckdb::LogicalTypeId::DOUBLE:
-			case duckdb::LogicalTypeId::DECIMAL:
-				switch (q->numericalPrecisionPolicy()) {
-				case QSql::LowPrecisionInt32:
-					val = val.CastAs(*stmt->context, duckdb::LogicalType::INTEGER);
-					valuesCache[i + in_idx] = duckdb::IntegerValue::Get(val);
-					break;
-				case QSql::LowPrecisionInt64:
-					val = val.CastAs(*stmt->context, duckdb::LogicalType::BIGINT);
-					valuesCache[i + in_idx] = QVariant((qint64)duckdb::BigIntValue::Get(val));
-					break;
-				case QSql::LowPrecisionDouble:
-				case QSql::HighPrecision:
-				default:
-					val = val.CastAs(*stmt->context, duckdb::LogicalType::DOUBLE);
-					valuesCache[i + in_idx] = duckdb::DoubleValue::Get(val);
-					break;
-				};
-				break;
-			default:
-				if (val.TryCastAs(*stmt->context, duckdb::LogicalType::VARCHAR)) {
-					valuesCache[i + in_idx] = QString::fromStdString(duckdb::StringValue::Get(val));
-				} else {
-					valuesCache[i + in_idx] = QVariant::fromValue(QString());
-				}
-				break;
+		}
+		qRegisterFileSystems(*access->db->instance);
+		qRegisterPlotFunctions(*access->db->instance);
+		access->con = duckdb::make_uniq<duckdb::Connection>(*access->db);
+		if (options.progressInterval > 0) {
+			// DuckDB only tracks the progress of a query while its progress bar is enabled
+			for (const char *setting : {"SET enable_progress_bar = true", "SET enable_progress_bar_print = false"}) {
+				auto result = access->con->Query(setting);
+				if (result->HasError())
+					result->ThrowError();
 			}
 		}
+
+		std::lock_guard<std::mutex> lock(accessMutex);
+		this->access = std::move(access);
+		deferredExtensionsLoaded = options.deferredExtensions.isEmpty();
+	} catch (std::exception &ex) {
+		auto errData = duckdb::ErrorData(ex);
+		error = qMakeError(errData, QCoreApplication::translate("QDuckDBDriver", "Error opening database"),
+		                   QSqlError::ConnectionError);
+		return false;
+	}
+	return true;
+}
+
+bool QDuckDBDriverPrivate::ensureAccess(QSqlError &error) {
+	if (!access && !openInstance(error))
+		return false;
+	if (deferredExtensionsLoaded)
 		return true;
-	};
+	try {
+		for (const auto &extension : options.deferredExtensions)
+			qLoadLinkedExtension(*access->db, extension);
+	} catch (std::exception &ex) {
+		auto errData = duckdb::ErrorData(ex);
+		error = qMakeError(errData, QCoreApplication::translate("QDuckDBDriver", "Unable to load extension"),
+		                   QSqlError::ConnectionError);
+		return false;
+	}
+	deferredExtensionsLoaded = true;
+	return true;
+}
 
-	///////////////
-	if (!stmt->result) {
-		// no result yet! call Execute()
-		if (!executeQuery()) {
-			return false;
-		}
+class QDuckDBResultPrivate : public QSqlCachedResultPrivate {
+	Q_DECLARE_PUBLIC(QDuckDBResult)
+
+public:
+	Q_DECLARE_SQLDRIVER_PRIVATE(QDuckDBDriver)
+	using QSqlCachedResultPrivate::QSqlCachedResultPrivate;
+	void cleanup();
+	// drops the result of the last execution, but keeps the prepared statement for executing it again
+	void resetExecution();
+	// replaces the statement prepare() kept with a new one of its query, e.g. after a schema change through another
+	// connection changed the types of its columns
+	bool prepareAgain();
+	bool fetchNext(QSqlCachedResult::ValueCache &values, qsizetype idx, bool initialFetch);
+	// initializes the recordInfo and the cache
+	void initColumns(bool emptyResultset);
+	void finalize();
+	// timeout of the next execution, QUERY_TIMEOUT_SETTING takes precedence over the connection option
+	std::chrono::milliseconds queryTimeout() const;
+	// emits queryProgress() if the sampling interval passed since the last report
+	void reportProgress();
+	// cardinality estimate of the prepared plan, -1 before prepare()
+	qlonglong estimatedRowCount() const;
+
+	// reused by every prepare() of this result, finalize() only drops the statement it holds and prepare() keeps it
+	// for the same query
+	std::unique_ptr<DuckDBStmt> stmt = nullptr;
+	QSqlRecord rInf;
+	QSqlCachedResult::ValueCache firstRow;
+	bool skippedStatus = false; // the status of the fetchNext() that's skipped
+	bool skipRow = false;       // skip the next fetchNext()?
+	QElapsedTimer lastProgress;
+};
+
+void QDuckDBResultPrivate::cleanup() {
+	Q_Q(QDuckDBResult);
+	finalize();
+	rInf.clear();
+	skippedStatus = false;
+	skipRow = false;
+	q->setAt(QSql::BeforeFirstRow);
+	q->setActive(false);
+	q->cleanup();
+}
+
+void QDuckDBResultPrivate::resetExecution() {
+	Q_Q(QDuckDBResult);
+	stmt->result.reset();
+	stmt->current_chunk.reset();
+	stmt->current_row = -1;
+	stmt->last_changes = 0;
+	stmt->timeout = std::chrono::milliseconds {0};
+	stmt->remaining = {};
+	rInf.clear();
+	skippedStatus = false;
+	skipRow = false;
+	q->setAt(QSql::BeforeFirstRow);
+	q->setActive(false);
+	q->cleanup();
+}
+
+void QDuckDBResultPrivate::finalize() {
+	if (!stmt)
+		return;
+
+	// keep the statement object, its context and the capacity of its vectors for the next prepare()
+	stmt->result.reset();
+	stmt->current_chunk.reset();
+	stmt->prepared.reset();
+	stmt->current_row.reset();
+	stmt->bound_values.clear();
+	stmt->last_changes = 0;
+	stmt->timeout = std::chrono::milliseconds {0};
+	stmt->remaining = {};
+	stmt->record.clear();
+	stmt->conversions.clear();
+	stmt->record_names.clear();
+	stmt->record_types.clear();
+	stmt->query.clear();
+	stmt->reused = false;
+}
+
+bool QDuckDBResultPrivate::prepareAgain() {
+	stmt->reused = false;
+	auto prepared = stmt->context->Prepare(stmt->query.toStdString());
+	if (prepared->HasError() || prepared->named_param_map.size() != stmt->bound_values.size())
+		return false;
+	stmt->prepared = std::move(prepared);
+	rInf.clear();
+	firstRow.resize(static_cast<qsizetype>(stmt->prepared->ColumnCount()));
+	return true;
+}
+
+void QDuckDBResultPrivate::initColumns(bool /*emptyResultset*/) {
+	Q_Q(QDuckDBResult);
+	if (!stmt || !stmt->prepared)
+		return;
+
+	duckdb::idx_t nCols = stmt->prepared->ColumnCount();
+	if (nCols <= 0)
+		return;
+
+	assert(nCols <= std::numeric_limits<int>::max());
+	q->init(static_cast<int>(nCols));
+
+	// the types of an executed result are those of the statement DuckDB ran, which differ from the prepared ones
+	// when DuckDB rebinds it for parameters of other types. The record is only built again when they change.
+	const bool executed = stmt->result && stmt->result->types.size() == nCols;
+	const auto &columnNamesVec = executed ? stmt->result->names : stmt->prepared->GetNames();
+	const auto &columnTypesVec = executed ? stmt->result->types : stmt->prepared->GetTypes();
+	if (columnNamesVec != stmt->record_names || columnTypesVec != stmt->record_types) {
+		stmt->record.clear();
+		stmt->conversions.clear();
+		stmt->conversions.reserve(nCols);
+		for (duckdb::idx_t i = 0; i < nCols; ++i) {
+			QString colName = QString::fromStdString(columnNamesVec[i]).remove(u'"');
+			auto fieldType = duckdbTypeToQtType(columnTypesVec[i].id());
+
+			QSqlField fld(colName, toQtType(fieldType));
+			stmt->record.append(fld);
+			stmt->conversions.push_back(qColumnConversion(columnTypesVec[i].id()));
+		}
+		stmt->record_names = columnNamesVec;
+		stmt->record_types = columnTypesVec;
+	}
+	rInf = stmt->record;
+}
+
+std::chrono::milliseconds QDuckDBResultPrivate::queryTimeout() const {
+	duckdb::Value value;
+	if (stmt->context->TryGetCurrentSetting(QUERY_TIMEOUT_SETTING, value) && !value.IsNull())
+		return std::chrono::milliseconds(value.GetValue<uint64_t>());
+	return drv_d_func()->options.queryTimeout;
+}
+
+void QDuckDBResultPrivate::reportProgress() {
+	const qint64 interval = drv_d_func()->options.progressInterval;
+	if (interval <= 0)
+		return;
+	if (lastProgress.isValid() && !lastProgress.hasExpired(interval))
+		return;
+	lastProgress.start();
+
+	auto progress = stmt->context->GetQueryProgress();
+	if (progress.GetPercentage() < 0)
+		return;
+	auto *driver = const_cast<QDuckDBDriver *>(drv_d_func()->q_func());
+	Q_EMIT driver->queryProgress(progress.GetPercentage(), progress.GetRowsProcesseed(),
+	                             progress.GetTotalRowsToProcess());
+}
+
+qlonglong QDuckDBResultPrivate::estimatedRowCount() const {
+	if (!stmt || !stmt->prepared || !stmt->prepared->data || !stmt->prepared->data->physical_plan)
+		return -1;
+	return static_cast<qlonglong>(stmt->prepared->data->physical_plan->Root().estimated_cardinality);
+}
+
+// whether a successfully executed statement may have changed tables, views or their columns
+static bool qMayChangeSchema(const duckdb::PreparedStatement &prepared) {
+	switch (prepared.GetStatementType()) {
+	case duckdb::StatementType::SELECT_STATEMENT:
+	case duckdb::StatementType::INSERT_STATEMENT:
+	case duckdb::StatementType::UPDATE_STATEMENT:
+	case duckdb::StatementType::DELETE_STATEMENT:
+	case duckdb::StatementType::EXPLAIN_STATEMENT:
+	case duckdb::StatementType::COPY_STATEMENT:
+		return false;
+	case duckdb::StatementType::TRANSACTION_STATEMENT: {
+		// a rollback, also written as ABORT, discards the schema changes of the transaction
+		const auto &statement = prepared.data->unbound_statement;
+		return !statement ||
+		       statement->Cast<duckdb::TransactionStatement>().info->type == duckdb::TransactionType::ROLLBACK;
+	}
+	default:
+		return true;
+	}
+}
+
+///////////////////////
+
+bool QDuckDBResultPrivate::fetchNext(QSqlCachedResult::ValueCache &valuesCache, qsizetype in_idx, bool initialFetch) {
+	Q_Q(QDuckDBResult);
+
+	if (skipRow) {
+		// already fetched
+		Q_ASSERT(!initialFetch);
+		skipRow = false;
+		for (qsizetype i = 0; i < firstRow.size(); i++)
+			valuesCache[i] = firstRow[i];
+		return skippedStatus;
+	}
+	skipRow = initialFetch;
+
+	if (initialFetch) {
+		firstRow.clear();
+		if (stmt && stmt->prepared)
+			firstRow.resize(static_cast<qsizetype>(stmt->prepared->ColumnCount()));
+	}
+
+	if (!stmt || !stmt->context) {
+		q->setLastError(QSqlError(QCoreApplication::translate("QDuckDbResult", "Unable to fetch row"),
+		                          QCoreApplication::translate("QDuckDbResult", "No query"),
+		                          QSqlError::ConnectionError));
+		q->setAt(QSql::AfterLastRow);
+		return false;
+	}
+	if (!stmt->prepared) {
+		q->setLastError(
+		    QSqlError(QCoreApplication::translate("QDuckDbResult", "Unable to fetch row"),
+		              QCoreApplication::translate("QDuckDbResult",
+		                                          "Attempting fetchNext() on a non-successfully prepared statement."),
+		              QSqlError::ConnectionError));
+		q->setAt(QSql::AfterLastRow);
+		return false;
+	}
+
+	std::optional<QueryTimeoutGuard> timeoutGuard;
+	auto buildError = [this, q, &timeoutGuard](duckdb::ErrorData &errData) {
+		const bool timedOut = timeoutGuard && timeoutGuard->release();
+		auto sqlError =
+		    qMakeError(errData,
+		               timedOut ? QCoreApplication::translate("QDuckDBResult", "Query timeout exceeded.")
+		                        : QCoreApplication::translate("QDuckDBResult", "Unable to fetch row."),
+		               QSqlError::ConnectionError);
+		stmt->result.reset();
+		stmt->current_chunk.reset();
+		q->setLastError(sqlError);
+		q->setAt(QSql::AfterLastRow);
+	};
+
+	auto fetchNext = [&]() {
+		duckdb::ErrorData errData;
+		if (!stmt->result->TryFetch(stmt->current_chunk, errData)) {
+			buildError(errData);
+			return false;
+		}
+		return true;
+	};
+
+	auto isDone = [&]() {
+		if (!stmt->current_chunk || stmt->current_chunk->size() == 0) {
+			if (rInf.isEmpty())
+				initColumns(true);
+			stmt->result = nullptr;
+			stmt->current_chunk = nullptr;
+			q->setAt(QSql::AfterLastRow);
+			return true;
+		}
+		return false;
+	};
+
+	auto startQuery = [&]() {
+		// registered models are copied on this thread, before DuckDB's threads scan them
+		try {
+			qSnapshotScanSources(*stmt->context, *stmt->prepared);
+		} catch (std::exception &ex) {
+			return duckdb::make_uniq<duckdb::PendingQueryResult>(duckdb::ErrorData(ex));
+		}
+		return stmt->prepared->PendingQuery(stmt->bound_values, true);
+	};
+
+	auto executeQuery = [&]() {
+		// drive the execution task by task instead of blocking in Execute(),
+		// so the connection can be interrupted between two tasks
+		auto pending = startQuery();
+		// DuckDB rebinds a kept statement after catalog changes, but fails if its result types changed
+		if (pending->HasError() && stmt->reused && prepareAgain())
+			pending = startQuery();
+		if (pending->HasError()) {
+			buildError(pending->GetErrorObject());
+			return false;
+		}
+		duckdb::PendingExecutionResult execResult;
+		lastProgress.invalidate();
+		while (!duckdb::PendingQueryResult::IsResultReady(execResult = pending->ExecuteTask())) {
+			if (execResult == duckdb::PendingExecutionResult::BLOCKED ||
+			    execResult == duckdb::PendingExecutionResult::NO_TASKS_AVAILABLE)
+				pending->WaitForTask();
+			reportProgress();
+			const auto &interruptCheck = drv_d_func()->interruptCheck;
+			if (interruptCheck && interruptCheck())
+				stmt->context->Interrupt();
+		}
+		if (execResult == duckdb::PendingExecutionResult::EXECUTION_ERROR) {
+			buildError(pending->GetErrorObject());
+			return false;
+		}
+		stmt->result = pending->Execute();
+		if (stmt->result->HasError()) {
+			// error in execute: clear prepared statement
+			buildError(stmt->result->GetErrorObject());
+			return false;
+		}
+		if (qMayChangeSchema(*stmt->prepared))
+			const_cast<QDuckDBDriverPrivate *>(drv_d_func())->invalidateMetadataCache();
+		return true;
+	};
+
+	auto collectStats = [&]() {
+		auto properties = stmt->prepared->GetStatementProperties();
+		if (properties.return_type == duckdb::StatementReturnType::CHANGED_ROWS && stmt->current_chunk &&
+		    stmt->current_chunk->size() > 0) {
+			// update total changes
+			auto row_changes = stmt->current_chunk->GetValue(0, 0);
+			if (!row_changes.IsNull() && row_changes.DefaultTryCastAs(duckdb::LogicalType::BIGINT)) {
+				stmt->last_changes = row_changes.GetValue<int64_t>();
+			}
+		}
+		if (properties.return_type != duckdb::StatementReturnType::QUERY_RESULT) {
+			stmt->current_chunk.reset();
+			stmt->result.reset();
+		}
+	};
+
+	auto fillRow = [&]() {
+		assert(stmt->current_row.has_value());
+		//// check to see if should fill out columns
+		if (rInf.isEmpty())
+			// must be first call.
+			initColumns(false);
+		if (in_idx < 0 && !initialFetch)
+			return true;
+		const qsizetype rowCount = rInf.count();
+		for (qsizetype i = 0; i < rowCount; ++i) {
+
+			duckdb::Value val = stmt->current_chunk->data[static_cast<size_t>(i)].GetValue(*stmt->current_row);
+			if (val.IsNull()) {
+				valuesCache[i + in_idx] = QVariant();
+				continue;
+			}
+			switch (stmt->conversions[static_cast<size_t>(i)]) {
+			case ColumnConversion::Blob: {
+				val = val.CastAs(*stmt->context, duckdb::LogicalType::BLOB);
+				const auto &str = duckdb::StringValue::Get(val);
+				valuesCache[i + in_idx] = QByteArray(str.data(), static_cast<qsizetype>(str.size()));
+				break;
+			}
+			case ColumnConversion::Signed:
+				val = val.CastAs(*stmt->context, duckdb::LogicalType::BIGINT);
+				valuesCache[i + in_idx] = qint64 {duckdb::BigIntValue::Get(val)};
+				break;
+			case ColumnConversion::Unsigned:
+				val = val.CastAs(*stmt->context, duckdb::LogicalType::UBIGINT);
+				valuesCache[i + in_idx] = quint64 {duckdb::UBigIntValue::Get(val)};
+				break;
+			case ColumnConversion::Decimal:
+				if (q->numericalPrecisionPolicy() == QSql::HighPrecision) {
+					// exact, like the numeric columns of the other Qt drivers
+					valuesCache[i + in_idx] = QString::fromStdString(val.ToString());
+					break;
+				}
+				Q_FALLTHROUGH();
+			case ColumnConversion::Floating:
+				switch (q->numericalPrecisionPolicy()) {
+				case QSql::LowPrecisionInt32:
+					val = val.CastAs(*stmt->context, duckdb::LogicalType::INTEGER);
+					valuesCache[i + in_idx] = duckdb::IntegerValue::Get(val);
+					break;
+				case QSql::LowPrecisionInt64:
+					val = val.CastAs(*stmt->context, duckdb::LogicalType::BIGINT);
+					valuesCache[i + in_idx] = QVariant((qint64)duckdb::BigIntValue::Get(val));
+					break;
+				case QSql::LowPrecisionDouble:
+				case QSql::HighPrecision:
+				default:
+					val = val.CastAs(*stmt->context, duckdb::LogicalType::DOUBLE);
+					valuesCache[i + in_idx] = duckdb::DoubleValue::Get(val);
+					break;
+				};
+				break;
+			case ColumnConversion::TimestampTz: {
+				// the instant in UTC, the text would carry the offset of the TimeZone setting. QDateTime has
+				// milliseconds, the microseconds are dropped. infinity and -infinity have no QDateTime, they are
+				// fetched as text like those of TIMESTAMP columns.
+				const auto stamp = val.GetValue<duckdb::timestamp_t>();
+				if (!duckdb::Timestamp::IsFinite(stamp)) {
+					valuesCache[i + in_idx] = QString::fromStdString(val.ToString());
+					break;
+				}
+				// rounded down, also before 1970
+				const int64_t ms = stamp.value / 1000 - (stamp.value % 1000 < 0 ? 1 : 0);
+				valuesCache[i + in_idx] = QDateTime::fromMSecsSinceEpoch(ms).toUTC();
+				break;
+			}
+			case ColumnConversion::Uuid:
+				valuesCache[i + in_idx] = QUuid(QString::fromStdString(val.ToString()));
+				break;
+			default:
+				if (val.TryCastAs(*stmt->context, duckdb::LogicalType::VARCHAR)) {
+					valuesCache[i + in_idx] = QString::fromStdString(duckdb::StringValue::Get(val));
+				} else {
+					valuesCache[i + in_idx] = QVariant::fromValue(QString());
+				}
+				break;
+			}
+		}
+		return true;
+	};
+
+	///////////////
+	if (!stmt->result) {
+		// no result yet! call Execute()
+		stmt->timeout = queryTimeout();
+		stmt->remaining = stmt->timeout;
+		timeoutGuard.emplace(*stmt);
+		if (!executeQuery()) {
+			return false;
+		}
 		// fetch a chunk
 		if (!fetchNext()) {
 			return false;
 		}
 
-		stmt->current_row = std::nullopt;
-		collectStats();
+		stmt->current_row = std::nullopt;
+		collectStats();
+	}
+	if (isDone()) {
+		return false;
+	}
+	if (stmt->current_row.has_value())
+		++(*stmt->current_row);
+	else
+		stmt->current_row = 0;
+	if (*(stmt->current_row) >= stmt->current_chunk->size()) {
+		// have to fetch again!
+		stmt->current_row = 0;
+		timeoutGuard.emplace(*stmt);
+		if (!fetchNext()) {
+			return false;
+		}
+		reportProgress();
+		if (isDone()) {
+			return false;
+		}
+	}
+	return fillRow();
+}
+
+QDuckDBResult::QDuckDBResult(const QDuckDBDriver *db) : QSqlCachedResult(*new QDuckDBResultPrivate(this, db)) {
+	Q_D(QDuckDBResult);
+	const_cast<QDuckDBDriverPrivate *>(d->drv_d_func())->results.append(this);
+}
+
+QDuckDBResult::~QDuckDBResult() {
+	Q_D(QDuckDBResult);
+	if (d->drv_d_func())
+		const_cast<QDuckDBDriverPrivate *>(d->drv_d_func())->results.removeOne(this);
+	d->cleanup();
+}
+
+bool QDuckDBResult::reset(const QString &query) {
+	if (!prepare(query))
+		return false;
+	return exec();
+}
+
+bool QDuckDBResult::prepare(const QString &query) {
+	Q_D(QDuckDBResult);
+	if (!driver() || !driver()->isOpen() || driver()->isOpenError())
+		return false;
+
+	QSqlError openError;
+	auto *drv = const_cast<QDuckDBDriverPrivate *>(d->drv_d_func());
+	if (!drv->ensureAccess(openError)) {
+		d->cleanup();
+		setLastError(openError);
+		return false;
+	}
+	auto &&db = drv->access;
+
+	// the statement prepared last, e.g. by QSqlQuery::exec(sql) in a loop: it is neither parsed nor planned again
+	// unless a statement of this driver changed the schema since. Changes through other connections are caught
+	// when executing it, see prepareAgain().
+	setSelect(false);
+	if (db && d->stmt && d->stmt->prepared && d->stmt->context == db->con->context && d->stmt->query == query &&
+	    d->stmt->schema_generation == drv->schemaGeneration) {
+		d->resetExecution();
+		d->stmt->reused = true;
+		return true;
+	}
+	d->cleanup();
+
+	const std::string query_str = query.toStdString();
+
+	auto build_error = [this, d](duckdb::ErrorData &errData) {
+		setLastError(qMakeError(errData, QCoreApplication::translate("QDuckDBResult", "Unable to execute statement"),
+		                        QSqlError::StatementError));
+		d->finalize();
+	};
+
+	if (!db) {
+		return false;
+	}
+	try {
+		auto prepared = db->con->Prepare(query_str);
+		if (prepared->HasError()) {
+			build_error(prepared->error);
+			return false;
+		}
+
+		// reuse the statement entry of the previous prepare()
+		if (!d->stmt)
+			d->stmt = duckdb::make_uniq<DuckDBStmt>();
+		if (d->stmt->context != db->con->context)
+			d->stmt->context = db->con->context;
+		d->stmt->prepared = std::move(prepared);
+		d->stmt->query = query;
+		d->stmt->schema_generation = drv->schemaGeneration;
+		d->stmt->reused = false;
+		d->stmt->current_row = -1;
+		d->stmt->bound_values.resize(d->stmt->prepared->named_param_map.size());
+
+		return true;
+	} catch (std::exception &ex) {
+		auto errData = duckdb::ErrorData(ex);
+		db->con->context->ProcessError(errData, query_str);
+		build_error(errData);
+		return false;
+	}
+	return false;
+}
+
+bool QDuckDBResult::execBatch(bool arrayBind) {
+	Q_UNUSED(arrayBind);
+	Q_D(QSqlResult);
+	QScopedValueRollback<QSqlCachedResult::ValueCache> valuesScope(d->values);
+	auto values = d->values;
+	if (values.size() == 0)
+		return false;
+
+	for (int i = 0; i < values.at(0).toList().size(); ++i) {
+		d->values.clear();
+		QScopedValueRollback<QSqlResultPrivate::IndexMap> indexesScope(d->indexes);
+		auto it = d->indexes.constBegin();
+		while (it != d->indexes.constEnd()) {
+			bindValue(it.key(), values.at(it.value().first()).toList().at(i), QSql::In);
+			++it;
+		}
+		if (!exec())
+			return false;
+	}
+	return true;
+}
+
+bool QDuckDBResult::exec() {
+	Q_D(QDuckDBResult);
+	auto values = boundValues();
+
+	if (!d->stmt || !d->stmt->prepared)
+		return false;
+
+	d->skippedStatus = false;
+	d->skipRow = false;
+	d->rInf.clear();
+	clearValues();
+	setLastError(QSqlError());
+
+	d->stmt->result.reset();
+	d->stmt->current_chunk.reset();
+
+	size_t paramCount = d->stmt->prepared->named_param_map.size();
+	if (paramCount != static_cast<size_t>(values.size())) {
+		setLastError(QSqlError(QCoreApplication::translate("QDuckDBResult", "Parameter count mismatch"), QString(),
+		                       QSqlError::StatementError));
+		return false;
+	}
+
+	assert(paramCount <= static_cast<size_t>(std::numeric_limits<qsizetype>::max()));
+	for (size_t i = 0; i < paramCount; ++i)
+		d->stmt->bound_values[i] = qToDuckDBValue(values.at(static_cast<qsizetype>(i)));
+
+	d->skippedStatus = d->fetchNext(d->firstRow, 0, true);
+	if (lastError().isValid()) {
+		setSelect(false);
+		setActive(false);
+		return false;
+	}
+	setSelect(!d->rInf.isEmpty());
+	setActive(true);
+	return true;
+}
+
+bool QDuckDBResult::gotoNext(QSqlCachedResult::ValueCache &row, int idx) {
+	Q_D(QDuckDBResult);
+	return d->fetchNext(row, static_cast<qsizetype>(idx), false);
+}
+
+int QDuckDBResult::size() {
+	// Q_D(QDuckDBResult);
+	return 0;
+}
+
+int QDuckDBResult::numRowsAffected() {
+	Q_D(const QDuckDBResult);
+	if (!d->stmt || !d->stmt->prepared)
+		return -1;
+
+	assert(d->stmt->last_changes <= std::numeric_limits<int>::max());
+	return static_cast<int>(d->stmt->last_changes);
+}
+
+QVariant QDuckDBResult::lastInsertId() const {
+	// Q_D(const QDuckDBResult);
+	return QVariant();
+}
+
+QVariant QDuckDBResult::handle() const {
+	Q_D(const QDuckDBResult);
+	DuckDBResultHandle handle;
+	if (d->stmt) {
+		handle.prepared = d->stmt->prepared.get();
+		handle.result = d->stmt->result.get();
+		if (d->stmt->current_chunk && d->stmt->current_row) {
+			handle.chunk = d->stmt->current_chunk.get();
+			handle.row = *d->stmt->current_row;
+		}
+	}
+	handle.estimatedRows = d->estimatedRowCount();
+	return QVariant::fromValue(handle);
+}
+
+QSqlRecord QDuckDBResult::record() const {
+	Q_D(const QDuckDBResult);
+	if (!isActive() || !isSelect())
+		return QSqlRecord();
+	return d->rInf;
+}
+
+void QDuckDBResult::detachFromResultSet() {
+	Q_D(QDuckDBResult);
+	if (d->stmt) {
+		d->stmt->result.reset();
+		d->stmt->current_chunk.reset();
+	}
+}
+
+/////////////////////////////////////////////////////////
+
+QDuckDBDriver::QDuckDBDriver(QObject *parent) : QSqlDriver(*new QDuckDBDriverPrivate, parent) {
+}
+
+QDuckDBDriver::~QDuckDBDriver() {
+	QDuckDBDriver::close();
+}
+
+bool QDuckDBDriver::hasFeature(DriverFeature f) const {
+	switch (f) {
+	case BLOB:
+	case Transactions:
+	case Unicode:
+	case PreparedQueries:
+	case PositionalPlaceholders:
+	case SimpleLocking:
+	case FinishQuery:
+	case LowPrecisionNumbers:
+	case CancelQuery:
+		return true;
+	case QuerySize:
+	case LastInsertId:
+	case NamedPlaceholders:
+	case EventNotifications:
+	case BatchOperations:
+	case MultipleResultSets:
+		return false;
+	}
+	return false;
+}
+
+bool QDuckDBDriver::open(const QString &db, const QString &, const QString &, const QString &, int,
+                         const QString &conOpts) {
+	Q_D(QDuckDBDriver);
+	if (isOpen())
+		close();
+
+	ConnectOptions options;
+	QString optionError;
+	if (!qParseConnectOptions(conOpts, options, optionError)) {
+		setLastError(QSqlError(tr("Error opening database"), optionError, QSqlError::ConnectionError));
+		setOpenError(true);
+		return false;
+	}
+	d->databaseName = db;
+	d->options = options;
+
+	if (!options.lazyOpen) {
+		QSqlError error;
+		if (!d->openInstance(error)) {
+			setLastError(error);
+			setOpenError(true);
+			return false;
+		}
+	}
+
+	QueryWatchdog::instance().retain();
+	setOpen(true);
+	setOpenError(false);
+	return true;
+}
+
+void QDuckDBDriver::close() {
+	Q_D(QDuckDBDriver);
+	if (isOpen()) {
+		for (QDuckDBResult *result : qtAsConst(d->results)) {
+			result->d_func()->cleanup();
+			// the pooled statement holds the client context, which keeps the database alive
+			result->d_func()->stmt.reset();
+		}
+		if (d->access) {
+			qDropScanSources(d->access->con->context.get());
+			qDropBuffers(d->access->con->context.get());
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(d->accessMutex);
+			d->access.reset();
+		}
+		// the temporary views scanning them are gone with the connection
+		d->arrowStreams.clear();
+		d->invalidateMetadataCache();
+		setOpen(false);
+		setOpenError(false);
+		QueryWatchdog::instance().release();
+	}
+}
+
+bool QDuckDBDriver::cancelQuery() {
+	Q_D(QDuckDBDriver);
+	std::lock_guard<std::mutex> lock(d->accessMutex);
+	if (!d->access)
+		return false;
+	d->access->con->Interrupt();
+	return true;
+}
+
+QSqlResult *QDuckDBDriver::createResult() const {
+	return new QDuckDBResult(this);
+}
+
+bool QDuckDBDriver::beginTransaction() {
+	if (!isOpen() || isOpenError())
+		return false;
+
+	QSqlQuery q(createResult());
+	if (!q.exec("BEGIN"_L1)) {
+		setLastError(
+		    QSqlError(tr("Unable to begin transaction"), q.lastError().databaseText(), QSqlError::TransactionError));
+		return false;
+	}
+
+	return true;
+}
+
+bool QDuckDBDriver::commitTransaction() {
+	if (!isOpen() || isOpenError())
+		return false;
+
+	QSqlQuery q(createResult());
+	if (!q.exec("COMMIT"_L1)) {
+		setLastError(
+		    QSqlError(tr("Unable to commit transaction"), q.lastError().databaseText(), QSqlError::TransactionError));
+		return false;
+	}
+
+	return true;
+}
+
+bool QDuckDBDriver::rollbackTransaction() {
+	if (!isOpen() || isOpenError())
+		return false;
+
+	QSqlQuery q(createResult());
+	if (!q.exec("ROLLBACK"_L1)) {
+		setLastError(
+		    QSqlError(tr("Unable to rollback transaction"), q.lastError().databaseText(), QSqlError::TransactionError));
+		return false;
+	}
+
+	return true;
+}
+
+QStringList QDuckDBDriver::tables(QSql::TableType type) const {
+	Q_D(const QDuckDBDriver);
+	QStringList res;
+	if (!isOpen())
+		return res;
+
+	const auto cached = d->tablesCache.constFind(static_cast<int>(type));
+	if (cached != d->tablesCache.constEnd())
+		return *cached;
+
+	QSqlQuery q(createResult());
+	q.setForwardOnly(true);
+
+	const QString system_tables = (type & QSql::SystemTables) ? QString() : "WHERE internal = 'FALSE'"_L1;
+
+	if (type & QSql::Tables) {
+		const QString table_sql = "SELECT table_name FROM duckdb_tables() "_L1 + system_tables + ";"_L1;
+		if (q.exec(table_sql)) {
+			while (q.next())
+				res.append(q.value(0).toString());
+		}
+	}
+
+	if (type & QSql::Views) {
+		const QString view_sql = "SELECT view_name FROM duckdb_views() "_L1 + system_tables + ";"_L1;
+		if (q.exec(view_sql)) {
+			while (q.next())
+				res.append(q.value(0).toString());
+		}
+	}
+
+	const_cast<QDuckDBDriverPrivate *>(d)->tablesCache.insert(static_cast<int>(type), res);
+	return res;
+}
+
+// splits a possibly qualified and quoted table name into catalog, schema and table
+static bool qSplitTableName(const QString &name, QStringList &parts) {
+	parts = {QString()};
+	bool quoted = false;
+	QChar closing;
+	for (qsizetype i = 0; i < name.size(); ++i) {
+		const QChar c = name.at(i);
+		if (quoted) {
+			if (c != closing) {
+				parts.last().append(c);
+			} else if (closing == u'"' && i + 1 < name.size() && name.at(i + 1) == u'"') {
+				// escaped quote
+				parts.last().append(c);
+				++i;
+			} else {
+				quoted = false;
+			}
+		} else if (c == u'"' || c == u'[') {
+			quoted = true;
+			closing = c == u'"' ? QChar(u'"') : QChar(u']');
+		} else if (c == u'.') {
+			parts.append(QString());
+		} else {
+			parts.last().append(c);
+		}
 	}
-	if (isDone()) {
+	if (quoted || parts.size() > 3)
 		return false;
-	}
-	if (stmt->current_row.has_value())
-		++(*stmt->current_row);
-	else
-		stmt->current_row = 0;
-	if (*(stmt->current_row) >= stmt->current_chunk->size()) {
-		// have to fetch again!
-		stmt->current_row = 0;
-		if (!fetchNext()) {
+	for (const auto &part : qtAsConst(parts)) {
+		if (part.isEmpty())
 			return false;
+	}
+	return true;
+}
+
+// fetches the columns and primary keys of all tables with a single query.
+// Unqualified names are resolved like DuckDB does: temporary tables first, then the current schema.
+// "a.b" is the table b of schema a in the current database or of the default schema of database a.
+static bool qGetTableInfo(QSqlQuery &q, const QStringList &tableNames, QHash<QString, QSqlRecord> &records,
+                          QHash<QString, QSqlIndex> &primaryIndexes) {
+	QStringList lookups;
+	QVariantList params;
+	QStringList lookupNames;
+	for (const auto &tableName : tableNames) {
+		QStringList parts;
+		if (!qSplitTableName(tableName, parts)) {
+			records.insert(tableName, QSqlRecord());
+			primaryIndexes.insert(tableName, QSqlIndex());
+			continue;
 		}
-		if (isDone()) {
-			return false;
+		while (parts.size() < 3)
+			parts.prepend(QString());
+		lookups.append(QStringLiteral("(%1, ?::VARCHAR, ?::VARCHAR, ?::VARCHAR)").arg(lookupNames.size()));
+		for (const auto &part : qtAsConst(parts))
+			params.append(part.isEmpty() ? QVariant() : QVariant(part));
+		lookupNames.append(tableName);
+	}
+	if (lookupNames.isEmpty())
+		return true;
+
+	const QString sql =
+	    "SELECT l.idx, c.database_name, c.schema_name, c.column_name, c.data_type_id, c.is_nullable, "
+	    "c.column_default, c.numeric_precision, c.numeric_scale, c.character_maximum_length, "
+	    "list_position(k.constraint_column_names, c.column_name) "
+	    "FROM (VALUES "_L1 +
+	    lookups.join(", "_L1) +
+	    ") l(idx, catalog_name, schema_name, table_name) "
+	    "JOIN duckdb_columns() c ON lower(c.table_name) = lower(l.table_name) AND ("
+	    "(l.catalog_name IS NOT NULL AND lower(c.database_name) = lower(l.catalog_name) "
+	    "AND lower(c.schema_name) = lower(l.schema_name)) OR "
+	    "(l.catalog_name IS NULL AND l.schema_name IS NOT NULL AND ("
+	    "(c.database_name = current_database() AND lower(c.schema_name) = lower(l.schema_name)) OR "
+	    "(lower(c.database_name) = lower(l.schema_name) AND c.schema_name = 'main'))) OR "
+	    "(l.schema_name IS NULL AND ((c.database_name = current_database() AND c.schema_name = current_schema()) "
+	    "OR c.database_name = 'temp'))) "
+	    "LEFT JOIN (SELECT database_name, schema_name, table_name, constraint_column_names FROM duckdb_constraints() "
+	    "WHERE constraint_type = 'PRIMARY KEY') k "
+	    "ON k.database_name = c.database_name AND k.schema_name = c.schema_name AND k.table_name = c.table_name "
+	    "ORDER BY l.idx, c.database_name <> 'temp', c.database_name <> current_database(), c.database_name, "
+	    "c.schema_name, c.column_index"_L1;
+	if (!q.prepare(sql))
+		return false;
+	for (const auto &param : qtAsConst(params))
+		q.addBindValue(param);
+	if (!q.exec())
+		return false;
+
+	const auto lookupCount = static_cast<size_t>(lookupNames.size());
+	std::vector<QSqlRecord> tableRecords(lookupCount);
+	std::vector<std::vector<std::pair<qint64, QSqlField>>> keys(lookupCount);
+	std::vector<QString> resolved(lookupCount);
+	while (q.next()) {
+		const auto idx = static_cast<size_t>(q.value(0).toLongLong());
+		// an unqualified name may match several tables, the first one shadows the others
+		const QString table = q.value(1).toString() + u'.' + q.value(2).toString();
+		if (resolved[idx].isNull())
+			resolved[idx] = table;
+		else if (resolved[idx] != table)
+			continue;
+
+		const auto typeId = static_cast<duckdb::LogicalTypeId>(q.value(4).toInt());
+		QString defVal = q.value(6).toString();
+		if (!defVal.isEmpty() && defVal.at(0) == u'\'') {
+			const auto end = defVal.lastIndexOf(u'\'');
+			if (end > 0)
+				defVal = defVal.mid(1, end - 1);
 		}
+
+		QSqlField fld(q.value(3).toString(), toQtType(duckdbTypeToQtType(typeId)),
+		              lookupNames[static_cast<qsizetype>(idx)]);
+		fld.setRequired(!q.value(5).toBool());
+		fld.setDefaultValue(defVal);
+		// columns filled from a sequence
+		fld.setAutoValue(defVal.startsWith("nextval("_L1));
+		if (typeId == duckdb::LogicalTypeId::DECIMAL) {
+			// DECIMAL is fetched as double, keep its declared width and scale
+			fld.setLength(q.value(7).toInt());
+			fld.setPrecision(q.value(8).toInt());
+		}
+		tableRecords[idx].append(fld);
+		if (!q.value(10).isNull())
+			keys[idx].emplace_back(q.value(10).toLongLong(), fld);
 	}
-	return fillRow();
+
+	for (size_t i = 0; i < lookupCount; ++i) {
+		// primary key columns in the order of the constraint
+		std::sort(keys[i].begin(), keys[i].end(),
+		          [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+		QSqlIndex index;
+		for (const auto &key : keys[i])
+			index.append(key.second);
+		const QString &tableName = lookupNames[static_cast<qsizetype>(i)];
+		records.insert(tableName, tableRecords[i]);
+		primaryIndexes.insert(tableName, index);
+	}
+	return true;
 }
 
-QDuckDBResult::QDuckDBResult(const QDuckDBDriver *db) : QSqlCachedResult(*new QDuckDBResultPrivate(this, db)) {
-	Q_D(QDuckDBResult);
-	const_cast<QDuckDBDriverPrivate *>(d->drv_d_func())->results.append(this);
+QSqlIndex QDuckDBDriver::primaryIndex(const QString &tblname) const {
+	Q_D(const QDuckDBDriver);
+	if (!isOpen())
+		return QSqlIndex();
+
+	const auto cached = d->primaryIndexCache.constFind(tblname);
+	if (cached != d->primaryIndexCache.constEnd())
+		return *cached;
+	if (!const_cast<QDuckDBDriver *>(this)->prefetchMetadata({tblname}))
+		return QSqlIndex();
+	return d->primaryIndexCache.value(tblname);
 }
 
-QDuckDBResult::~QDuckDBResult() {
-	Q_D(QDuckDBResult);
-	if (d->drv_d_func())
-		const_cast<QDuckDBDriverPrivate *>(d->drv_d_func())->results.removeOne(this);
-	d->cleanup();
+QSqlRecord QDuckDBDriver::record(const QString &tbl) const {
+	Q_D(const QDuckDBDriver);
+	if (!isOpen())
+		return QSqlRecord();
+
+	const auto cached = d->recordCache.constFind(tbl);
+	if (cached != d->recordCache.constEnd())
+		return *cached;
+	if (!const_cast<QDuckDBDriver *>(this)->prefetchMetadata({tbl}))
+		return QSqlRecord();
+	return d->recordCache.value(tbl);
 }
 
-bool QDuckDBResult::reset(const QString &query) {
-	if (!prepare(query))
+bool QDuckDBDriver::prefetchMetadata(const QStringList &tables) {
+	Q_D(QDuckDBDriver);
+	if (!isOpen())
 		return false;
-	return exec();
-}
 
-bool QDuckDBResult::prepare(const QString &query) {
-	Q_D(QDuckDBResult);
-	if (!driver() || !driver()->isOpen() || driver()->isOpenError())
+	QStringList missing;
+	for (const auto &table : tables) {
+		if (!d->recordCache.contains(table) || !d->primaryIndexCache.contains(table))
+			missing.append(table);
+	}
+	missing.removeDuplicates();
+	if (missing.isEmpty())
+		return true;
+
+	QSqlQuery q(createResult());
+	q.setForwardOnly(true);
+	QHash<QString, QSqlRecord> records;
+	QHash<QString, QSqlIndex> primaryIndexes;
+	if (!qGetTableInfo(q, missing, records, primaryIndexes))
 		return false;
+	for (auto it = records.cbegin(); it != records.cend(); ++it)
+		d->recordCache.insert(it.key(), it.value());
+	for (auto it = primaryIndexes.cbegin(); it != primaryIndexes.cend(); ++it)
+		d->primaryIndexCache.insert(it.key(), it.value());
+	return true;
+}
 
-	d->cleanup();
+// cardinality estimate of the topmost operator of an EXPLAIN (FORMAT JSON) plan which has one
+static qlonglong qEstimatedCardinality(const QJsonArray &operators) {
+	for (const auto &op : operators) {
+		const QJsonObject node = op.toObject();
+		const QJsonValue estimate = node.value("extra_info"_L1).toObject().value("Estimated Cardinality"_L1);
+		qlonglong rows = -1;
+		if (estimate.isString()) {
+			bool ok = false;
+			rows = estimate.toString().toLongLong(&ok);
+			if (!ok)
+				rows = -1;
+		} else if (estimate.isDouble()) {
+			rows = static_cast<qlonglong>(estimate.toDouble());
+		}
+		if (rows >= 0)
+			return rows;
+		const qlonglong childRows = qEstimatedCardinality(node.value("children"_L1).toArray());
+		if (childRows >= 0)
+			return childRows;
+	}
+	return -1;
+}
 
-	setSelect(false);
+qlonglong QDuckDBDriver::estimateRowCount(const QString &query, const QVariantList &params) const {
+	if (!isOpen())
+		return -1;
 
-	const auto &query_str = query.toStdString();
-	auto &&db = d->drv_d_func()->access;
+	QSqlQuery q(createResult());
+	q.setForwardOnly(true);
+	if (!q.prepare("EXPLAIN (FORMAT JSON) "_L1 + query))
+		return -1;
+	for (const auto &param : params)
+		q.addBindValue(param);
+	if (!q.exec() || !q.next())
+		return -1;
+	const QJsonDocument plan = QJsonDocument::fromJson(q.value(q.record().count() - 1).toString().toUtf8());
+	return qEstimatedCardinality(plan.isArray() ? plan.array() : QJsonArray {plan.object()});
+}
 
-	auto build_error = [this, d](duckdb::ErrorData &errData) {
-		setLastError(qMakeError(errData, QCoreApplication::translate("QDuckDBResult", "Unable to execute statement"),
-		                        QSqlError::StatementError));
-		d->finalize();
-	};
+qlonglong QDuckDBDriver::estimateResultRowCount(void *result) const {
+	Q_D(const QDuckDBDriver);
+	const auto found = std::find_if(d->results.cbegin(), d->results.cend(), [result](QDuckDBResult *candidate) {
+		return static_cast<void *>(static_cast<QSqlResult *>(candidate)) == result;
+	});
+	return found == d->results.cend() ? -1 : (*found)->d_func()->estimatedRowCount();
+}
 
-	if (!db) {
+// rows per Arrow record batch, the default of DuckDB's Python client
+static constexpr duckdb::idx_t ARROW_BATCH_ROWS = 1000000;
+
+// stream of an exported result. DuckDB's stream ends silently once another statement executed on the connection
+// closed the streamed result, this one fails with EIO instead, unless the result had already been read completely.
+struct ExportedArrowStream {
+	ArrowArrayStream inner;                        // stream of DuckDB's ResultArrowArrayStreamWrapper
+	duckdb::StreamQueryResult *streamed = nullptr; // the result inner reads, nullptr if it is materialized
+	bool ended = false;
+	std::string error;
+
+	static ExportedArrowStream &self(ArrowArrayStream *stream) {
+		return *static_cast<ExportedArrowStream *>(stream->private_data);
+	}
+	static int getSchema(ArrowArrayStream *stream, ArrowSchema *out) {
+		auto &exported = self(stream);
+		return exported.inner.get_schema(&exported.inner, out);
+	}
+	static int getNext(ArrowArrayStream *stream, ArrowArray *out) {
+		auto &exported = self(stream);
+		if (exported.ended) {
+			out->release = nullptr;
+			return 0;
+		}
+		if (exported.streamed && !exported.streamed->IsOpen()) {
+			exported.error = "The result was closed by another statement executed on the connection";
+			return EIO;
+		}
+		const int status = exported.inner.get_next(&exported.inner, out);
+		// a batch which reaches the end of the result closes it, before any other statement could
+		if (status == 0 && (!out->release || (exported.streamed && !exported.streamed->IsOpen())))
+			exported.ended = true;
+		return status;
+	}
+	static const char *getLastError(ArrowArrayStream *stream) {
+		auto &exported = self(stream);
+		return exported.error.empty() ? exported.inner.get_last_error(&exported.inner) : exported.error.c_str();
+	}
+	static void release(ArrowArrayStream *stream) {
+		auto *exported = &self(stream);
+		exported->inner.release(&exported->inner);
+		delete exported;
+		stream->release = nullptr;
+	}
+};
+
+// executes the prepared statement and hands its streamed result over to an ArrowArrayStream, which owns it
+static bool qExportArrowStream(duckdb::PreparedStatement &prepared, duckdb::vector<duckdb::Value> &values,
+                               void *stream, QSqlError &error) {
+	if (prepared.named_param_map.size() != values.size()) {
+		error = QSqlError(QCoreApplication::translate("QDuckDBDriver", "Parameter count mismatch"), QString(),
+		                  QSqlError::StatementError);
+		return false;
+	}
+	qSnapshotScanSources(*prepared.context, prepared);
+	auto result = prepared.Execute(values, true);
+	if (result->HasError()) {
+		error = qMakeError(result->GetErrorObject(),
+		                   QCoreApplication::translate("QDuckDBDriver", "Unable to export result"),
+		                   QSqlError::StatementError);
+		return false;
+	}
+	auto *streamed = result->type == duckdb::QueryResultType::STREAM_RESULT
+	                     ? &result->Cast<duckdb::StreamQueryResult>()
+	                     : nullptr;
+	// the stream keeps the wrapper alive until its release callback deletes it
+	auto *wrapper = new duckdb::ResultArrowArrayStreamWrapper(std::move(result), ARROW_BATCH_ROWS);
+	auto *exported = new ExportedArrowStream {wrapper->stream, streamed};
+	auto &out = *static_cast<ArrowArrayStream *>(stream);
+	out.get_schema = ExportedArrowStream::getSchema;
+	out.get_next = ExportedArrowStream::getNext;
+	out.get_last_error = ExportedArrowStream::getLastError;
+	out.release = ExportedArrowStream::release;
+	out.private_data = exported;
+	return true;
+}
+
+bool QDuckDBDriver::exportArrowStream(const QString &query, const QVariantList &params, void *stream) {
+	Q_D(QDuckDBDriver);
+	QSqlError error;
+	if (!stream || !isOpen() || !d->ensureAccess(error)) {
+		setLastError(error);
 		return false;
 	}
+	const std::string query_str = query.toStdString();
 	try {
-		auto prepared = db->con->Prepare(query.toStdString());
+		auto prepared = d->access->con->Prepare(query_str);
 		if (prepared->HasError()) {
-			build_error(prepared->error);
+			setLastError(qMakeError(prepared->error, tr("Unable to export result"), QSqlError::StatementError));
 			return false;
 		}
-
-		// create the statement entry
-		d->stmt = duckdb::make_uniq<DuckDBStmt>();
-		d->stmt->context = db->con->context;
-		d->stmt->prepared = std::move(prepared);
-		d->stmt->current_row = -1;
-		d->stmt->bound_values.resize(d->stmt->prepared->named_param_map.size());
-
+		duckdb::vector<duckdb::Value> values;
+		values.reserve(static_cast<duckdb::idx_t>(params.size()));
+		for (const auto &param : params)
+			values.push_back(qToDuckDBValue(param));
+		if (!qExportArrowStream(*prepared, values, stream, error)) {
+			setLastError(error);
+			return false;
+		}
+		if (qMayChangeSchema(*prepared))
+			d->invalidateMetadataCache();
 		return true;
 	} catch (std::exception &ex) {
 		auto errData = duckdb::ErrorData(ex);
-		db->con->context->ProcessError(errData, query_str);
-		build_error(errData);
+		setLastError(qMakeError(errData, tr("Unable to export result"), QSqlError::StatementError));
 		return false;
 	}
-	return false;
 }
 
-bool QDuckDBResult::execBatch(bool arrayBind) {
-	Q_UNUSED(arrayBind);
-	Q_D(QSqlResult);
-	QScopedValueRollback<QSqlCachedResult::ValueCache> valuesScope(d->values);
-	auto values = d->values;
-	if (values.size() == 0)
+bool QDuckDBDriver::exportResultArrowStream(void *result, void *stream) {
+	Q_D(QDuckDBDriver);
+	// only results of this driver are accepted, result may be any QSqlResult
+	const auto found = std::find_if(d->results.cbegin(), d->results.cend(), [result](QDuckDBResult *candidate) {
+		return static_cast<void *>(static_cast<QSqlResult *>(candidate)) == result;
+	});
+	if (!stream || found == d->results.cend()) {
+		setLastError(QSqlError(tr("Unable to export result"), tr("The query does not belong to this driver"),
+		                       QSqlError::StatementError));
 		return false;
-
-	for (int i = 0; i < values.at(0).toList().size(); ++i) {
-		d->values.clear();
-		QScopedValueRollback<QSqlResultPrivate::IndexMap> indexesScope(d->indexes);
-		auto it = d->indexes.constBegin();
-		while (it != d->indexes.constEnd()) {
-			bindValue(it.key(), values.at(it.value().first()).toList().at(i), QSql::In);
-			++it;
-		}
-		if (!exec())
-			return false;
 	}
-	return true;
-}
-
-bool QDuckDBResult::exec() {
-	Q_D(QDuckDBResult);
-	auto values = boundValues();
-
-	if (!d->stmt)
-		return false;
-
-	d->skippedStatus = false;
-	d->skipRow = false;
-	d->rInf.clear();
-	clearValues();
-	setLastError(QSqlError());
-
-	d->stmt->result.reset();
-	d->stmt->current_chunk.reset();
-
-	size_t paramCount = d->stmt->prepared->named_param_map.size();
-	if (paramCount != static_cast<size_t>(values.size())) {
-		setLastError(QSqlError(QCoreApplication::translate("QDuckDBResult", "Parameter count mismatch"), QString(),
+	QDuckDBResult *source = *found;
+	const auto &stmt = source->d_func()->stmt;
+	if (!stmt || !stmt->prepared) {
+		setLastError(QSqlError(tr("Unable to export result"), tr("The query is not prepared"),
 		                       QSqlError::StatementError));
 		return false;
 	}
-
-	assert(paramCount <= static_cast<size_t>(std::numeric_limits<qsizetype>::max()));
-	for (size_t i = 0; i < paramCount; ++i) {
-		const QVariant &value = values.at(static_cast<qsizetype>(i));
-		if (value.isNull()) {
-			d->stmt->bound_values[i] = duckdb::Value();
-		} else {
-			switch (value.userType()) {
-			case QMetaType::QByteArray: {
-				const QByteArray *ba = static_cast<const QByteArray *>(value.constData());
-				d->stmt->bound_values[i] = duckdb::Value::BLOB_RAW(ba->toStdString());
-				break;
-			}
-			case QMetaType::Bool:
-			case QMetaType::Char:
-			case QMetaType::SChar:
-			case QMetaType::Short:
-			case QMetaType::Int:
-			case QMetaType::Long:
-			case QMetaType::LongLong:
-				d->stmt->bound_values[i] = duckdb::Value::BIGINT(value.toLongLong());
-				break;
-			case QMetaType::Double:
-				d->stmt->bound_values[i] = duckdb::Value::DOUBLE(value.toDouble());
-				break;
-			case QMetaType::Float:
-				d->stmt->bound_values[i] = duckdb::Value::DOUBLE(static_cast<double>(value.toFloat()));
-				break;
-			case QMetaType::UChar:
-			case QMetaType::UShort:
-			case QMetaType::UInt:
-			case QMetaType::ULong:
-			case QMetaType::ULongLong:
-				d->stmt->bound_values[i] = duckdb::Value::UBIGINT(value.toULongLong());
-				break;
-			case QMetaType::QDateTime: {
-				const QDateTime dateTime = value.toDateTime();
-				const QString str = dateTime.toString(Qt::ISODateWithMs);
-				d->stmt->bound_values[i] = duckdb::Value(str.toStdString());
-				break;
-			}
-			case QMetaType::QDate: {
-				const QDate date = value.toDate();
-				const QString str = date.toString(Qt::ISODate);
-				d->stmt->bound_values[i] = duckdb::Value(str.toStdString());
-				break;
-			}
-			case QMetaType::QTime: {
-				const QTime time = value.toTime();
-				const QString str = time.toString(u"hh:mm:ss.zzz");
-				d->stmt->bound_values[i] = duckdb::Value(str.toStdString());
-				break;
-			}
-			case QMetaType::QString: {
-				const QString *str = static_cast<const QString *>(value.constData());
-				d->stmt->bound_values[i] = duckdb::Value(str->toUtf8().toStdString());
-				break;
-			}
-			default: {
-				const QString str = value.toString();
-				d->stmt->bound_values[i] = duckdb::Value(str.toStdString());
-				break;
-			}
-			}
+	try {
+		duckdb::vector<duckdb::Value> values;
+		for (const auto &value : source->boundValues())
+			values.push_back(qToDuckDBValue(value));
+		QSqlError error;
+		if (!qExportArrowStream(*stmt->prepared, values, stream, error)) {
+			setLastError(error);
+			return false;
 		}
-	}
-
-	d->skippedStatus = d->fetchNext(d->firstRow, 0, true);
-	if (lastError().isValid()) {
-		setSelect(false);
-		setActive(false);
+		if (qMayChangeSchema(*stmt->prepared))
+			d->invalidateMetadataCache();
+		return true;
+	} catch (std::exception &ex) {
+		auto errData = duckdb::ErrorData(ex);
+		setLastError(qMakeError(errData, tr("Unable to export result"), QSqlError::StatementError));
 		return false;
 	}
-	setSelect(!d->rInf.isEmpty());
-	setActive(true);
-	return true;
 }
 
-bool QDuckDBResult::gotoNext(QSqlCachedResult::ValueCache &row, int idx) {
-	Q_D(QDuckDBResult);
-	return d->fetchNext(row, static_cast<qsizetype>(idx), false);
+// arrow_scan callbacks for a stream owned by the driver. DuckDB reads a copy without release callback,
+// so the stream stays with the driver and its buffers are scanned in place.
+static void qArrowKeepStream(ArrowArrayStream *stream) {
+	stream->release = nullptr;
 }
 
-int QDuckDBResult::size() {
-	// Q_D(QDuckDBResult);
-	return 0;
+static duckdb::unique_ptr<duckdb::ArrowArrayStreamWrapper> qArrowProduce(uintptr_t factory,
+                                                                         duckdb::ArrowStreamParameters &) {
+	auto wrapper = duckdb::make_uniq<duckdb::ArrowArrayStreamWrapper>();
+	wrapper->arrow_array_stream = *reinterpret_cast<ArrowArrayStream *>(factory);
+	wrapper->arrow_array_stream.release = qArrowKeepStream;
+	return wrapper;
 }
 
-int QDuckDBResult::numRowsAffected() {
-	Q_D(const QDuckDBResult);
-	if (!d->stmt)
-		return -1;
-
-	assert(d->stmt->last_changes <= std::numeric_limits<int>::max());
-	return static_cast<int>(d->stmt->last_changes);
+static void qArrowGetSchema(ArrowArrayStream *factory, ArrowSchema &schema) {
+	factory->get_schema(factory, &schema);
 }
 
-QVariant QDuckDBResult::lastInsertId() const {
-	// Q_D(const QDuckDBResult);
-	return QVariant();
-}
+bool QDuckDBDriver::registerArrowStream(const QString &name, void *stream) {
+	Q_D(QDuckDBDriver);
+	QSqlError error;
+	auto *source = static_cast<ArrowArrayStream *>(stream);
+	if (!source || !source->release || name.isEmpty() || !isOpen() || !d->ensureAccess(error)) {
+		setLastError(error);
+		return false;
+	}
 
-QSqlRecord QDuckDBResult::record() const {
-	Q_D(const QDuckDBResult);
-	if (!isActive() || !isSelect())
-		return QSqlRecord();
-	return d->rInf;
+	// the stream moves into the driver once the view exists
+	std::shared_ptr<ArrowArrayStream> owned(new ArrowArrayStream(*source), [](ArrowArrayStream *released) {
+		if (released->release)
+			released->release(released);
+		delete released;
+	});
+	const duckdb::stream_factory_produce_t produce = qArrowProduce;
+	const duckdb::stream_factory_get_schema_t getSchema = qArrowGetSchema;
+	try {
+		d->access->con
+		    ->TableFunction("arrow_scan", {duckdb::Value::POINTER(reinterpret_cast<uintptr_t>(owned.get())),
+		                                   duckdb::Value::POINTER(reinterpret_cast<uintptr_t>(produce)),
+		                                   duckdb::Value::POINTER(reinterpret_cast<uintptr_t>(getSchema))})
+		    ->CreateView(name.toStdString(), true, true);
+	} catch (std::exception &ex) {
+		owned->release = nullptr;
+		auto errData = duckdb::ErrorData(ex);
+		setLastError(qMakeError(errData, tr("Unable to register Arrow stream"), QSqlError::StatementError));
+		return false;
+	}
+	source->release = nullptr;
+	// replaces and releases the stream of a previous view of the same name
+	d->arrowStreams.insert(name, owned);
+	d->invalidateMetadataCache();
+	return true;
 }
 
-void QDuckDBResult::detachFromResultSet() {
-	Q_D(QDuckDBResult);
-	if (d->stmt) {
-		d->stmt->result.reset();
-		d->stmt->current_chunk.reset();
+bool QDuckDBDriver::unregisterArrowStream(const QString &name) {
+	Q_D(QDuckDBDriver);
+	if (!d->arrowStreams.contains(name) || !d->access)
+		return false;
+	try {
+		auto result = d->access->con->Query(std::string("DROP VIEW IF EXISTS temp.") +
+		                                    escapeIdentifier(name, QSqlDriver::FieldName).toStdString());
+		if (result->HasError()) {
+			setLastError(qMakeError(result->GetErrorObject(), tr("Unable to unregister Arrow stream"),
+			                        QSqlError::StatementError));
+			return false;
+		}
+	} catch (std::exception &ex) {
+		auto errData = duckdb::ErrorData(ex);
+		setLastError(qMakeError(errData, tr("Unable to unregister Arrow stream"), QSqlError::StatementError));
+		return false;
 	}
+	d->arrowStreams.remove(name);
+	d->invalidateMetadataCache();
+	return true;
 }
 
-/////////////////////////////////////////////////////////
+qlonglong QDuckDBDriver::ingestArrowStream(const QString &table, void *stream, bool create) {
+	Q_D(QDuckDBDriver);
+	const QString view = "qt_duckdb_ingest_"_L1 + QString::number(++d->arrowIngestCount);
+	if (!registerArrowStream(view, stream)) {
+		auto *source = static_cast<ArrowArrayStream *>(stream);
+		if (source && source->release)
+			source->release(source);
+		return -1;
+	}
+	qlonglong rows = -1;
+	{
+		QSqlQuery q(createResult());
+		const QString sql = create ? "CREATE TABLE %1 AS SELECT * FROM %2"_L1 : "INSERT INTO %1 SELECT * FROM %2"_L1;
+		if (q.exec(sql.arg(escapeIdentifier(table, QSqlDriver::TableName),
+		                   escapeIdentifier(view, QSqlDriver::FieldName))))
+			rows = q.numRowsAffected();
+		else
+			setLastError(q.lastError());
+	}
+	unregisterArrowStream(view);
+	return rows;
+}
 
-QDuckDBDriver::QDuckDBDriver(QObject *parent) : QSqlDriver(*new QDuckDBDriverPrivate, parent) {
+bool QDuckDBDriver::registerModel(const QString &name, QObject *model) {
+	auto *itemModel = qobject_cast<QAbstractItemModel *>(model);
+	if (!itemModel) {
+		setLastError(QSqlError(tr("Unable to register model"), tr("The object is not a QAbstractItemModel"),
+		                       QSqlError::StatementError));
+		return false;
+	}
+	auto source = std::make_shared<ScanSource>();
+	source->model = itemModel;
+	QSqlError error;
+	if (!d_func()->registerScanSource(name, std::move(source), error)) {
+		setLastError(error);
+		return false;
+	}
+	return true;
 }
 
-QDuckDBDriver::~QDuckDBDriver() {
-	QDuckDBDriver::close();
+bool QDuckDBDriver::registerColumns(const QString &name, qlonglong rows, const QVariantList &columns) {
+	auto source = std::make_shared<ScanSource>();
+	source->rows = static_cast<duckdb::idx_t>(qMax<qlonglong>(0, rows));
+	for (const auto &column : columns) {
+		const QVariantMap spec = column.toMap();
+		ScanColumn scanColumn;
+		scanColumn.name = spec.value("name"_L1).toString().toStdString();
+		scanColumn.type = qScanColumnType(spec.value("type"_L1).toString());
+		scanColumn.data = reinterpret_cast<const char *>(static_cast<uintptr_t>(spec.value("data"_L1).toULongLong()));
+		scanColumn.stride = spec.value("stride"_L1).toLongLong();
+		if (scanColumn.name.empty() || scanColumn.type.id() == duckdb::LogicalTypeId::INVALID ||
+		    (!scanColumn.data && source->rows > 0) || scanColumn.stride < 0) {
+			setLastError(QSqlError(tr("Unable to register columns"),
+			                       tr("Invalid column %1").arg(spec.value("name"_L1).toString()),
+			                       QSqlError::StatementError));
+			return false;
+		}
+		source->columns.push_back(std::move(scanColumn));
+	}
+	if (source->columns.empty()) {
+		setLastError(QSqlError(tr("Unable to register columns"), tr("No columns"), QSqlError::StatementError));
+		return false;
+	}
+	QSqlError error;
+	if (!d_func()->registerScanSource(name, std::move(source), error)) {
+		setLastError(error);
+		return false;
+	}
+	return true;
 }
 
-bool QDuckDBDriver::hasFeature(DriverFeature f) const {
-	switch (f) {
-	case BLOB:
-	case Transactions:
-	case Unicode:
-	case PreparedQueries:
-	case PositionalPlaceholders:
-	case SimpleLocking:
-	case FinishQuery:
-	case LowPrecisionNumbers:
-		return true;
-	case QuerySize:
-	case LastInsertId:
-	case NamedPlaceholders:
-	case EventNotifications:
-	case BatchOperations:
-	case MultipleResultSets:
-	case CancelQuery:
+bool QDuckDBDriverPrivate::registerScanSource(const QString &name, std::shared_ptr<ScanSource> source,
+                                              QSqlError &error) {
+	Q_Q(QDuckDBDriver);
+	if (name.isEmpty() || !q->isOpen() || !ensureAccess(error))
+		return false;
+	auto &con = *access->con;
+	const std::string key = name.toStdString();
+	const QString descr = QCoreApplication::translate("QDuckDBDriver", "Unable to register source");
+	try {
+		qRegisterScanFunction(con);
+		{
+			auto &registry = scanSourceRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.sources[con.context.get()][key] = std::move(source);
+		}
+		QString literal = name;
+		literal.replace(u'\'', "''"_L1);
+		auto result =
+		    con.Query(("CREATE OR REPLACE TEMP VIEW "_L1 + _q_escapeIdentifier(name, QSqlDriver::FieldName) +
+		               " AS SELECT * FROM qt_source('"_L1 + literal + "')"_L1)
+		                  .toStdString());
+		if (result->HasError()) {
+			qDropScanSource(con.context.get(), key);
+			error = qMakeError(result->GetErrorObject(), descr, QSqlError::StatementError);
+			return false;
+		}
+	} catch (std::exception &ex) {
+		qDropScanSource(con.context.get(), key);
+		auto errData = duckdb::ErrorData(ex);
+		error = qMakeError(errData, descr, QSqlError::StatementError);
 		return false;
 	}
-	return false;
+	invalidateMetadataCache();
+	return true;
 }
 
-bool QDuckDBDriver::open(const QString &db, const QString &, const QString &, const QString &, int,
-                         const QString &conOpts) {
+bool QDuckDBDriver::unregisterSource(const QString &name) {
 	Q_D(QDuckDBDriver);
-	if (isOpen())
-		close();
+	if (!d->access || !qDropScanSource(d->access->con->context.get(), name.toStdString()))
+		return false;
+	auto result = d->access->con->Query(std::string("DROP VIEW IF EXISTS temp.") +
+	                                    escapeIdentifier(name, QSqlDriver::FieldName).toStdString());
+	d->invalidateMetadataCache();
+	return !result->HasError();
+}
+
+// writes the queued chunks to device until the statement returned
+static qint64 qPumpDevice(DeviceSink &sink, QIODevice *device, const std::function<void()> &progress) {
+	qint64 total = 0;
+	for (;;) {
+		QByteArray chunk;
+		{
+			std::unique_lock<std::mutex> lock(sink.mutex);
+			sink.changed.wait_for(lock, std::chrono::milliseconds(100),
+			                      [&sink] { return sink.finished || !sink.chunks.empty(); });
+			if (sink.chunks.empty()) {
+				if (sink.finished)
+					return total;
+				lock.unlock();
+				progress();
+				continue;
+			}
+			chunk = std::move(sink.chunks.front());
+			sink.chunks.pop_front();
+			sink.queued -= chunk.size();
+			sink.changed.notify_all();
+			if (sink.failed)
+				continue;
+		}
+		qint64 offset = 0;
+		while (offset < chunk.size()) {
+			const qint64 n = device->write(chunk.constData() + offset, chunk.size() - offset);
+			if (n < 0)
+				break;
+			offset += n;
+		}
+		// sequential devices like sockets buffer what they could not send yet
+		while (offset == chunk.size() && device->bytesToWrite() > DEVICE_QUEUE_BYTES) {
+			if (!device->waitForBytesWritten(-1))
+				offset = -1;
+		}
+		if (offset != chunk.size()) {
+			std::lock_guard<std::mutex> lock(sink.mutex);
+			sink.failed = true;
+			sink.deviceError = device->errorString();
+			sink.changed.notify_all();
+			continue;
+		}
+		total += offset;
+		progress();
+	}
+}
 
-	bool openReadOnlyOption = false;
-	for (const auto &option : conOpts.split(u';')) {
-		if (option.trimmed() == "READONLY"_L1) {
-			openReadOnlyOption = true;
+// the statement of exportToDevice() on its own thread. Stops and joins it when leaving the scope, also if writing
+// the device threw, and unregisters its sink.
+struct DeviceExport {
+	std::string id;
+	std::shared_ptr<DeviceSink> sink;
+	duckdb::ClientContext *context = nullptr;
+	std::thread statement;
+
+	~DeviceExport() {
+		if (statement.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(sink->mutex);
+				if (!sink->finished) {
+					sink->failed = true;
+					sink->deviceError = "The export was aborted"_L1;
+					context->Interrupt();
+				}
+				sink->changed.notify_all();
+			}
+			statement.join();
 		}
+		std::lock_guard<std::mutex> lock(deviceSinksMutex);
+		deviceSinks.erase(id);
+	}
+};
+
+// executes prepared on the statement thread of exportToDevice() task by task, recording the progress in sink
+static duckdb::unique_ptr<duckdb::QueryResult> qExecuteExport(duckdb::PreparedStatement &prepared,
+                                                              duckdb::vector<duckdb::Value> &values,
+                                                              duckdb::ClientContext &context, DeviceSink &sink) {
+	auto pending = prepared.PendingQuery(values, false);
+	if (pending->HasError())
+		return duckdb::make_uniq<duckdb::MaterializedQueryResult>(pending->GetErrorObject());
+	duckdb::PendingExecutionResult execResult;
+	while (!duckdb::PendingQueryResult::IsResultReady(execResult = pending->ExecuteTask())) {
+		if (execResult == duckdb::PendingExecutionResult::BLOCKED ||
+		    execResult == duckdb::PendingExecutionResult::NO_TASKS_AVAILABLE)
+			pending->WaitForTask();
+		const auto progress = context.GetQueryProgress();
+		std::lock_guard<std::mutex> lock(sink.mutex);
+		sink.percentage = progress.GetPercentage();
+		sink.rowsProcessed = progress.GetRowsProcesseed();
+		sink.totalRowsToProcess = progress.GetTotalRowsToProcess();
 	}
+	if (execResult == duckdb::PendingExecutionResult::EXECUTION_ERROR)
+		return duckdb::make_uniq<duckdb::MaterializedQueryResult>(pending->GetErrorObject());
+	return pending->Execute();
+}
 
+qlonglong QDuckDBDriver::exportToDevice(const QString &query, const QVariantList &params, QObject *device,
+                                        const QString &format, const QString &options) {
+	Q_D(QDuckDBDriver);
+	QSqlError error;
+	auto *target = qobject_cast<QIODevice *>(device);
+	if (!target || !target->isWritable()) {
+		setLastError(QSqlError(tr("Unable to export result"), tr("The device is not open for writing"),
+		                       QSqlError::StatementError));
+		return -1;
+	}
+	if (!isOpen() || !d->ensureAccess(error)) {
+		setLastError(error);
+		return -1;
+	}
+	// the format is part of the path and the statement, so only the formats of QDuckDBExport::Format are accepted
+	const QString formatName = format.toLower();
+	if (formatName != "csv"_L1 && formatName != "json"_L1 && formatName != "parquet"_L1) {
+		setLastError(QSqlError(tr("Unable to export result"), tr("Unknown format %1").arg(format),
+		                       QSqlError::StatementError));
+		return -1;
+	}
+	static std::atomic<int> exportCount {0};
+	const std::string id = DEVICE_PATH_PREFIX + std::to_string(++exportCount);
+	QString copy = "COPY ("_L1 + query + ") TO '"_L1 + QString::fromStdString(id) + "/export."_L1 + formatName +
+	               "' (FORMAT "_L1 + formatName;
+	if (!options.isEmpty())
+		copy += ", "_L1 + options;
+	copy += ")"_L1;
+
+	auto sink = std::make_shared<DeviceSink>();
+	duckdb::unique_ptr<duckdb::QueryResult> result;
 	try {
-		d->access = duckdb::make_uniq<DbHandle>();
-		duckdb::DBConfig config;
-		config.options.access_mode = duckdb::AccessMode::AUTOMATIC;
-		if (openReadOnlyOption) {
-			config.options.access_mode = duckdb::AccessMode::READ_ONLY;
+		auto prepared = d->access->con->Prepare(copy.toStdString());
+		if (prepared->HasError()) {
+			setLastError(qMakeError(prepared->error, tr("Unable to export result"), QSqlError::StatementError));
+			return -1;
 		}
-		d->access->db = duckdb::make_uniq<duckdb::DuckDB>(db.toStdString(), &config);
-		d->access->con = duckdb::make_uniq<duckdb::Connection>(*d->access->db);
-	} catch (std::exception &ex) {
-		if (d->access) {
-			auto errData = duckdb::ErrorData(ex);
-			setLastError(qMakeError(errData, tr("Error opening database"), QSqlError::ConnectionError));
-			setOpenError(true);
+		if (prepared->named_param_map.size() != static_cast<duckdb::idx_t>(params.size())) {
+			setLastError(QSqlError(tr("Parameter count mismatch"), QString(), QSqlError::StatementError));
+			return -1;
+		}
+		duckdb::vector<duckdb::Value> values;
+		for (const auto &param : params)
+			values.push_back(qToDuckDBValue(param));
 
-			d->access.reset();
-			return false;
+		{
+			std::lock_guard<std::mutex> lock(deviceSinksMutex);
+			deviceSinks[id] = sink;
+		}
+		auto *context = d->access->con->context.get();
+		qSnapshotScanSources(*context, *prepared);
+		qint64 written = 0;
+		{
+			// the statement runs on its own thread so that this one can write the device, which may not be used
+			// from DuckDB's threads (e.g. a socket)
+			DeviceExport running {id, sink, context, {}};
+			running.statement = std::thread([&prepared, &values, &result, &sink, context] {
+				try {
+					result = qExecuteExport(*prepared, values, *context, *sink);
+				} catch (std::exception &ex) {
+					result = duckdb::make_uniq<duckdb::MaterializedQueryResult>(duckdb::ErrorData(ex));
+				}
+				std::lock_guard<std::mutex> lock(sink->mutex);
+				sink->finished = true;
+				sink->changed.notify_all();
+			});
+			QElapsedTimer lastProgress;
+			const qint64 interval = d->options.progressInterval;
+			written = qPumpDevice(*sink, target, [&] {
+				if (interval <= 0 || (lastProgress.isValid() && !lastProgress.hasExpired(interval)))
+					return;
+				lastProgress.start();
+				double percentage;
+				quint64 rowsProcessed, totalRowsToProcess;
+				{
+					std::lock_guard<std::mutex> lock(sink->mutex);
+					percentage = sink->percentage;
+					rowsProcessed = sink->rowsProcessed;
+					totalRowsToProcess = sink->totalRowsToProcess;
+				}
+				if (percentage >= 0)
+					Q_EMIT queryProgress(percentage, rowsProcessed, totalRowsToProcess);
+			});
+		}
+		if (result->HasError()) {
+			setLastError(qMakeError(result->GetErrorObject(), tr("Unable to export result"),
+			                        QSqlError::StatementError));
+			return -1;
 		}
+		return written;
+	} catch (std::exception &ex) {
+		std::lock_guard<std::mutex> lock(deviceSinksMutex);
+		deviceSinks.erase(id);
+		auto errData = duckdb::ErrorData(ex);
+		setLastError(qMakeError(errData, tr("Unable to export result"), QSqlError::StatementError));
+		return -1;
 	}
+}
 
-	setOpen(true);
-	setOpenError(false);
+bool QDuckDBDriver::registerBuffer(const QString &name, const QByteArray &data) {
+	Q_D(QDuckDBDriver);
+	QSqlError error;
+	if (!isOpen() || !d->ensureAccess(error)) {
+		setLastError(error);
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(bufferRegistryMutex);
+	bufferRegistry[d->access->con->context.get()][name.toStdString()] = data;
 	return true;
 }
 
-void QDuckDBDriver::close() {
+bool QDuckDBDriver::unregisterBuffer(const QString &name) {
 	Q_D(QDuckDBDriver);
-	if (isOpen()) {
-		for (QDuckDBResult *result : qtAsConst(d->results)) {
-			result->d_func()->cleanup();
-		}
+	return d->access && qDropBuffer(d->access->con->context.get(), name.toStdString());
+}
 
-		d->access.reset();
-		setOpen(false);
-		setOpenError(false);
+// fixed-width types of QDuckDBFunctionDefinition, INVALID for others
+static duckdb::LogicalType qFunctionType(const QString &name) {
+	try {
+		auto type = duckdb::TransformStringToLogicalType(name.toStdString());
+		switch (type.id()) {
+		case duckdb::LogicalTypeId::BOOLEAN:
+		case duckdb::LogicalTypeId::TINYINT:
+		case duckdb::LogicalTypeId::SMALLINT:
+		case duckdb::LogicalTypeId::INTEGER:
+		case duckdb::LogicalTypeId::BIGINT:
+		case duckdb::LogicalTypeId::UTINYINT:
+		case duckdb::LogicalTypeId::USMALLINT:
+		case duckdb::LogicalTypeId::UINTEGER:
+		case duckdb::LogicalTypeId::UBIGINT:
+		case duckdb::LogicalTypeId::FLOAT:
+		case duckdb::LogicalTypeId::DOUBLE:
+			return type;
+		default:
+			break;
+		}
+	} catch (std::exception &) {
 	}
+	return duckdb::LogicalType::INVALID;
 }
 
-QSqlResult *QDuckDBDriver::createResult() const {
-	return new QDuckDBResult(this);
+// calls the function of a scalar UDF with the flat arrays of its arguments
+static duckdb::scalar_function_t qScalarFunction(std::shared_ptr<QDuckDBFunctionDefinition> definition) {
+	return [definition](duckdb::DataChunk &args, duckdb::ExpressionState &, duckdb::Vector &result) {
+		const auto count = args.size();
+		args.Flatten();
+		result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+		auto &validity = duckdb::FlatVector::Validity(result);
+		std::vector<const void *> arguments(args.ColumnCount());
+		for (duckdb::idx_t i = 0; i < args.ColumnCount(); ++i) {
+			arguments[i] = duckdb::FlatVector::GetData(args.data[i]);
+			validity.Combine(duckdb::FlatVector::Validity(args.data[i]), count);
+		}
+		definition->scalar(static_cast<qsizetype>(count), arguments.data(), duckdb::FlatVector::GetData(result));
+	};
 }
 
-bool QDuckDBDriver::beginTransaction() {
-	if (!isOpen() || isOpenError())
-		return false;
+// the definition of an aggregate UDF, passed from its function info to the bind data of its calls
+struct UdfAggregateInfo : public duckdb::AggregateFunctionInfo {
+	explicit UdfAggregateInfo(std::shared_ptr<QDuckDBFunctionDefinition> definition)
+	    : definition(std::move(definition)) {}
+	std::shared_ptr<QDuckDBFunctionDefinition> definition;
+};
 
-	QSqlQuery q(createResult());
-	if (!q.exec("BEGIN"_L1)) {
-		setLastError(
-		    QSqlError(tr("Unable to begin transaction"), q.lastError().databaseText(), QSqlError::TransactionError));
-		return false;
+struct UdfAggregateBindData : public duckdb::FunctionData {
+	explicit UdfAggregateBindData(std::shared_ptr<QDuckDBFunctionDefinition> definition)
+	    : definition(std::move(definition)) {}
+	duckdb::unique_ptr<duckdb::FunctionData> Copy() const override {
+		return duckdb::make_uniq<UdfAggregateBindData>(definition);
 	}
+	bool Equals(const duckdb::FunctionData &other) const override {
+		return definition == other.Cast<UdfAggregateBindData>().definition;
+	}
+	std::shared_ptr<QDuckDBFunctionDefinition> definition;
+};
 
-	return true;
+static const QDuckDBFunctionDefinition &qUdfDefinition(duckdb::AggregateInputData &input) {
+	return *input.bind_data->Cast<UdfAggregateBindData>().definition;
 }
 
-bool QDuckDBDriver::commitTransaction() {
-	if (!isOpen() || isOpenError())
-		return false;
-
-	QSqlQuery q(createResult());
-	if (!q.exec("COMMIT"_L1)) {
-		setLastError(
-		    QSqlError(tr("Unable to commit transaction"), q.lastError().databaseText(), QSqlError::TransactionError));
-		return false;
-	}
+// the DuckDB state of a group holds a pointer to the state created by the definition
+static duckdb::idx_t qUdfStateSize(const duckdb::AggregateFunction &) {
+	return sizeof(void *);
+}
 
-	return true;
+static void qUdfInitialize(const duckdb::AggregateFunction &function, duckdb::data_ptr_t state) {
+	*reinterpret_cast<void **>(state) = function.function_info->Cast<UdfAggregateInfo>().definition->create();
 }
 
-bool QDuckDBDriver::rollbackTransaction() {
-	if (!isOpen() || isOpenError())
-		return false;
+static duckdb::unique_ptr<duckdb::FunctionData> qUdfBind(duckdb::ClientContext &, duckdb::AggregateFunction &function,
+                                                         duckdb::vector<duckdb::unique_ptr<duckdb::Expression>> &) {
+	return duckdb::make_uniq<UdfAggregateBindData>(function.function_info->Cast<UdfAggregateInfo>().definition);
+}
 
-	QSqlQuery q(createResult());
-	if (!q.exec("ROLLBACK"_L1)) {
-		setLastError(
-		    QSqlError(tr("Unable to rollback transaction"), q.lastError().databaseText(), QSqlError::TransactionError));
-		return false;
+// adds the given rows of the inputs to state, as arrays of the rows with no NULL argument
+static void qUdfUpdateRows(const QDuckDBFunctionDefinition &definition, void *state,
+                           const duckdb::vector<duckdb::UnifiedVectorFormat> &inputs,
+                           const duckdb::vector<duckdb::idx_t> &widths, const std::vector<duckdb::idx_t> &rows) {
+	std::vector<std::vector<char>> gathered(inputs.size());
+	std::vector<const void *> arguments(inputs.size());
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		gathered[i].resize(rows.size() * widths[i]);
+		for (size_t row = 0; row < rows.size(); ++row)
+			std::memcpy(gathered[i].data() + row * widths[i],
+			            inputs[i].data + inputs[i].sel->get_index(rows[row]) * widths[i], widths[i]);
+		arguments[i] = gathered[i].data();
 	}
+	definition.update(state, static_cast<qsizetype>(rows.size()), arguments.data());
+}
 
-	return true;
+static void qUdfUpdate(duckdb::Vector inputs[], duckdb::AggregateInputData &aggr_input_data, duckdb::idx_t input_count,
+                       duckdb::Vector &states, duckdb::idx_t count) {
+	const auto &definition = qUdfDefinition(aggr_input_data);
+	duckdb::vector<duckdb::UnifiedVectorFormat> formats(input_count);
+	duckdb::vector<duckdb::idx_t> widths(input_count);
+	for (duckdb::idx_t i = 0; i < input_count; ++i) {
+		inputs[i].ToUnifiedFormat(count, formats[i]);
+		widths[i] = duckdb::GetTypeIdSize(inputs[i].GetType().InternalType());
+	}
+	duckdb::UnifiedVectorFormat stateFormat;
+	states.ToUnifiedFormat(count, stateFormat);
+	const auto statePointers = duckdb::UnifiedVectorFormat::GetData<duckdb::data_ptr_t>(stateFormat);
+
+	// one call per group, in the order the groups appear in the chunk
+	std::unordered_map<duckdb::data_ptr_t, size_t> groupIndex;
+	std::vector<std::pair<duckdb::data_ptr_t, std::vector<duckdb::idx_t>>> groups;
+	for (duckdb::idx_t row = 0; row < count; ++row) {
+		bool valid = true;
+		for (const auto &format : formats)
+			valid = valid && format.validity.RowIsValid(format.sel->get_index(row));
+		if (!valid)
+			continue;
+		const auto state = statePointers[stateFormat.sel->get_index(row)];
+		const auto inserted = groupIndex.emplace(state, groups.size());
+		if (inserted.second)
+			groups.emplace_back(state, std::vector<duckdb::idx_t>());
+		groups[inserted.first->second].second.push_back(row);
+	}
+	for (const auto &group : groups)
+		qUdfUpdateRows(definition, *reinterpret_cast<void **>(group.first), formats, widths, group.second);
 }
 
-QStringList QDuckDBDriver::tables(QSql::TableType type) const {
-	QStringList res;
-	if (!isOpen())
-		return res;
+static void qUdfSimpleUpdate(duckdb::Vector inputs[], duckdb::AggregateInputData &aggr_input_data,
+                             duckdb::idx_t input_count, duckdb::data_ptr_t state, duckdb::idx_t count) {
+	const auto &definition = qUdfDefinition(aggr_input_data);
+	duckdb::vector<duckdb::UnifiedVectorFormat> formats(input_count);
+	duckdb::vector<duckdb::idx_t> widths(input_count);
+	for (duckdb::idx_t i = 0; i < input_count; ++i) {
+		inputs[i].ToUnifiedFormat(count, formats[i]);
+		widths[i] = duckdb::GetTypeIdSize(inputs[i].GetType().InternalType());
+	}
+	std::vector<duckdb::idx_t> rows;
+	rows.reserve(count);
+	for (duckdb::idx_t row = 0; row < count; ++row) {
+		bool valid = true;
+		for (const auto &format : formats)
+			valid = valid && format.validity.RowIsValid(format.sel->get_index(row));
+		if (valid)
+			rows.push_back(row);
+	}
+	qUdfUpdateRows(definition, *reinterpret_cast<void **>(state), formats, widths, rows);
+}
 
-	QSqlQuery q(createResult());
-	q.setForwardOnly(true);
+static void qUdfCombine(duckdb::Vector &source, duckdb::Vector &target, duckdb::AggregateInputData &aggr_input_data,
+                        duckdb::idx_t count) {
+	const auto &definition = qUdfDefinition(aggr_input_data);
+	duckdb::UnifiedVectorFormat sourceFormat;
+	source.ToUnifiedFormat(count, sourceFormat);
+	const auto sources = duckdb::UnifiedVectorFormat::GetData<duckdb::data_ptr_t>(sourceFormat);
+	const auto targets = duckdb::FlatVector::GetData<duckdb::data_ptr_t>(target);
+	for (duckdb::idx_t i = 0; i < count; ++i)
+		definition.combine(*reinterpret_cast<void **>(targets[i]),
+		                   *reinterpret_cast<void **>(sources[sourceFormat.sel->get_index(i)]));
+}
 
-	const QString system_tables = (type & QSql::SystemTables) ? QString() : "WHERE internal = 'FALSE'"_L1;
+static void qUdfFinalize(duckdb::Vector &states, duckdb::AggregateInputData &aggr_input_data, duckdb::Vector &result,
+                         duckdb::idx_t count, duckdb::idx_t offset) {
+	const auto &definition = qUdfDefinition(aggr_input_data);
+	const auto width = duckdb::GetTypeIdSize(result.GetType().InternalType());
+	if (states.GetVectorType() == duckdb::VectorType::CONSTANT_VECTOR) {
+		result.SetVectorType(duckdb::VectorType::CONSTANT_VECTOR);
+		const auto state = *duckdb::ConstantVector::GetData<duckdb::data_ptr_t>(states);
+		definition.finalize(*reinterpret_cast<void **>(state), duckdb::ConstantVector::GetData(result));
+		return;
+	}
+	result.SetVectorType(duckdb::VectorType::FLAT_VECTOR);
+	const auto statePointers = duckdb::FlatVector::GetData<duckdb::data_ptr_t>(states);
+	const auto data = duckdb::FlatVector::GetData(result);
+	for (duckdb::idx_t i = 0; i < count; ++i)
+		definition.finalize(*reinterpret_cast<void **>(statePointers[i]), data + (i + offset) * width);
+}
 
-	if (type & QSql::Tables) {
-		const QString table_sql = "SELECT table_name FROM duckdb_tables() "_L1 + system_tables + ";"_L1;
-		if (q.exec(table_sql)) {
-			while (q.next())
-				res.append(q.value(0).toString());
-		}
+static void qUdfDestroy(duckdb::Vector &states, duckdb::AggregateInputData &aggr_input_data, duckdb::idx_t count) {
+	const auto &definition = qUdfDefinition(aggr_input_data);
+	const auto statePointers = duckdb::FlatVector::GetData<duckdb::data_ptr_t>(states);
+	for (duckdb::idx_t i = 0; i < count; ++i) {
+		auto &state = *reinterpret_cast<void **>(statePointers[i]);
+		if (state)
+			definition.destroy(state);
+		state = nullptr;
 	}
+}
 
-	if (type & QSql::Views) {
-		const QString view_sql = "SELECT view_name FROM duckdb_views() "_L1 + system_tables + ";"_L1;
-		if (q.exec(view_sql)) {
-			while (q.next())
-				res.append(q.value(0).toString());
+bool QDuckDBDriver::registerFunction(void *definition) {
+	Q_D(QDuckDBDriver);
+	QSqlError error;
+	if (!definition || !isOpen() || !d->ensureAccess(error)) {
+		setLastError(error);
+		return false;
+	}
+	// copied, DuckDB keeps calling it after the caller's definition is gone
+	auto udf = std::make_shared<QDuckDBFunctionDefinition>(*static_cast<QDuckDBFunctionDefinition *>(definition));
+	const bool aggregate = udf->kind == QDuckDBFunctionDefinition::Aggregate;
+	duckdb::vector<duckdb::LogicalType> arguments;
+	for (const auto &name : qtAsConst(udf->argumentTypes))
+		arguments.push_back(qFunctionType(name));
+	const auto returnType = qFunctionType(udf->returnType);
+	const bool typesValid =
+	    returnType.id() != duckdb::LogicalTypeId::INVALID &&
+	    std::none_of(arguments.begin(), arguments.end(),
+	                 [](const duckdb::LogicalType &type) { return type.id() == duckdb::LogicalTypeId::INVALID; });
+	const bool complete = aggregate ? udf->create && udf->update && udf->combine && udf->finalize && udf->destroy
+	                                : bool(udf->scalar);
+	if (udf->name.isEmpty() || !typesValid || !complete) {
+		setLastError(QSqlError(tr("Unable to register function"),
+		                       tr("Functions need a name, fixed-width types and all their callbacks"),
+		                       QSqlError::StatementError));
+		return false;
+	}
+	try {
+		const std::string name = udf->name.toStdString();
+		if (!aggregate) {
+			d->access->con->CreateVectorizedFunction(name, arguments, returnType, qScalarFunction(udf));
+			return true;
 		}
+		duckdb::AggregateFunction function(name, arguments, returnType, qUdfStateSize, qUdfInitialize, qUdfUpdate,
+		                                   qUdfCombine, qUdfFinalize,
+		                                   duckdb::FunctionNullHandling::DEFAULT_NULL_HANDLING, qUdfSimpleUpdate,
+		                                   qUdfBind, qUdfDestroy);
+		function.function_info = duckdb::make_shared_ptr<UdfAggregateInfo>(udf);
+		duckdb::UDFWrapper::RegisterAggrFunction(function, *d->access->con->context);
+		return true;
+	} catch (std::exception &ex) {
+		auto errData = duckdb::ErrorData(ex);
+		setLastError(qMakeError(errData, tr("Unable to register function"), QSqlError::StatementError));
+		return false;
 	}
+}
 
-	return res;
+// the column type of QDuckDBColumn for a result column
+// the numerical precision policy applies like to values fetched with next()
+static QDuckDBColumn::Type qColumnType(const duckdb::LogicalType &type, QSql::NumericalPrecisionPolicy policy) {
+	switch (type.id()) {
+	case duckdb::LogicalTypeId::BOOLEAN:
+	case duckdb::LogicalTypeId::TINYINT:
+	case duckdb::LogicalTypeId::SMALLINT:
+	case duckdb::LogicalTypeId::INTEGER:
+	case duckdb::LogicalTypeId::BIGINT:
+	case duckdb::LogicalTypeId::UTINYINT:
+	case duckdb::LogicalTypeId::USMALLINT:
+	case duckdb::LogicalTypeId::UINTEGER:
+		return QDuckDBColumn::Integer;
+	case duckdb::LogicalTypeId::DECIMAL:
+		if (policy == QSql::HighPrecision)
+			return QDuckDBColumn::Text;
+		Q_FALLTHROUGH();
+	case duckdb::LogicalTypeId::FLOAT:
+	case duckdb::LogicalTypeId::DOUBLE:
+		if (policy == QSql::LowPrecisionInt32 || policy == QSql::LowPrecisionInt64)
+			return QDuckDBColumn::Integer;
+		return QDuckDBColumn::Real;
+	default:
+		// including UBIGINT and HUGEINT, which neither qint64 nor double hold exactly
+		return QDuckDBColumn::Text;
+	}
 }
 
-static QSqlIndex qGetTableInfo(QSqlQuery &q, const QString &tableName, bool onlyPIndex = false) {
-	QString schema;
-	QString table(tableName);
-	const qsizetype indexOfSeparator = tableName.indexOf(u'.');
-	if (indexOfSeparator > -1) {
-		const qsizetype indexOfCloseBracket = tableName.indexOf(u']');
-		if (indexOfCloseBracket != tableName.size() - 1) {
-			// Handles a case like databaseName.tableName
-			schema = tableName.left(indexOfSeparator + 1);
-			table = tableName.mid(indexOfSeparator + 1);
-		} else {
-			const qsizetype indexOfOpenBracket = tableName.lastIndexOf(u'[', indexOfCloseBracket);
-			if (indexOfOpenBracket > 0) {
-				// Handles a case like databaseName.[tableName]
-				schema = tableName.left(indexOfOpenBracket);
-				table = tableName.mid(indexOfOpenBracket);
+// sets the bits of rows rows..rows + count - 1 which are valid in mask from offset on. The bits are stored byte by
+// byte, least significant bit first, as QBitArray::fromBits() reads them.
+static void qAppendValidity(std::vector<uint8_t> &bits, duckdb::idx_t rows, const duckdb::ValidityMask &mask,
+                            duckdb::idx_t offset, duckdb::idx_t count) {
+	bits.resize((rows + count + 7) / 8, 0);
+	const duckdb::idx_t end = rows + count;
+	if (mask.AllValid()) {
+		for (duckdb::idx_t i = rows; i < end;) {
+			if (i % 8 == 0 && i + 8 <= end) {
+				bits[i / 8] = 0xff;
+				i += 8;
+			} else {
+				bits[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+				++i;
 			}
 		}
+		return;
 	}
+	for (duckdb::idx_t i = 0; i < count; ++i) {
+		if (mask.RowIsValid(offset + i))
+			bits[(rows + i) / 8] |= static_cast<uint8_t>(1u << ((rows + i) % 8));
+	}
+}
 
-	q.exec("PRAGMA "_L1 + schema + "table_info ("_L1 + _q_escapeIdentifier(table, QSqlDriver::TableName) + u')');
-	QSqlIndex ind;
-	while (q.next()) {
-		bool isPk = q.value(5).toInt();
-		if (onlyPIndex && !isPk)
-			continue;
-		QString typeName = q.value(2).toString().toLower();
-		QString defVal = q.value(4).toString();
-		if (!defVal.isEmpty() && defVal.at(0) == u'\'') {
-			const auto end = defVal.lastIndexOf(u'\'');
-			if (end > 0)
-				defVal = defVal.mid(1, end - 1);
-		}
+// grows values to hold size values, doubling the capacity like appending would
+template <typename T>
+static void qGrowColumn(QVector<T> &values, qsizetype size) {
+	using Size = decltype(values.size());
+	if (size > values.capacity())
+		values.reserve(static_cast<Size>(std::max<qsizetype>(size, 2 * qsizetype(values.capacity()))));
+	values.resize(static_cast<Size>(size));
+}
 
-		QSqlField fld(q.value(1).toString(), toQtType(qGetColumnType(typeName)), tableName);
-		if (isPk && (typeName == "integer"_L1))
-			// INTEGER PRIMARY KEY fields are auto-generated in sqlite
-			// INT PRIMARY KEY is not the same as INTEGER PRIMARY KEY!
-			fld.setAutoValue(true);
-		fld.setRequired(q.value(3).toInt() != 0);
-		fld.setDefaultValue(defVal);
-		ind.append(fld);
+// appends count values of vector, a column of a chunk of size rows, from offset on to column
+static void qAppendColumn(duckdb::ClientContext &context, duckdb::Vector &vector, duckdb::idx_t size,
+                          duckdb::idx_t offset, duckdb::idx_t count, QDuckDBColumn &column,
+                          std::vector<uint8_t> &validity, duckdb::idx_t rows) {
+	const auto target = column.type == QDuckDBColumn::Integer ? duckdb::LogicalType::BIGINT
+	                    : column.type == QDuckDBColumn::Real  ? duckdb::LogicalType::DOUBLE
+	                                                          : duckdb::LogicalType::VARCHAR;
+	// only allocated for columns which are cast
+	duckdb::unique_ptr<duckdb::Vector> converted;
+	duckdb::Vector *source = &vector;
+	if (vector.GetType() != target) {
+		converted = duckdb::make_uniq<duckdb::Vector>(target, size);
+		duckdb::VectorOperations::Cast(context, vector, *converted, size);
+		source = converted.get();
+	}
+	source->Flatten(size);
+	qAppendValidity(validity, rows, duckdb::FlatVector::Validity(*source), offset, count);
+
+	const auto first = static_cast<qsizetype>(rows);
+	const auto end = static_cast<qsizetype>(rows + count);
+	switch (column.type) {
+	case QDuckDBColumn::Integer:
+		qGrowColumn(column.integers, end);
+		std::memcpy(column.integers.data() + first, duckdb::FlatVector::GetData<int64_t>(*source) + offset,
+		            count * sizeof(int64_t));
+		break;
+	case QDuckDBColumn::Real:
+		qGrowColumn(column.reals, end);
+		std::memcpy(column.reals.data() + first, duckdb::FlatVector::GetData<double>(*source) + offset,
+		            count * sizeof(double));
+		break;
+	case QDuckDBColumn::Text: {
+		const auto strings = duckdb::FlatVector::GetData<duckdb::string_t>(*source);
+		const auto &mask = duckdb::FlatVector::Validity(*source);
+		column.texts.reserve(static_cast<decltype(column.texts.size())>(end));
+		for (duckdb::idx_t i = offset; i < offset + count; ++i) {
+			if (!mask.RowIsValid(i)) {
+				column.texts.append(QString());
+				continue;
+			}
+			column.texts.append(QString::fromUtf8(strings[i].GetData(), static_cast<qsizetype>(strings[i].GetSize())));
+		}
+		break;
+	}
 	}
-	return ind;
 }
 
-QSqlIndex QDuckDBDriver::primaryIndex(const QString &tblname) const {
-	if (!isOpen())
-		return QSqlIndex();
+bool QDuckDBDriver::fetchColumns(void *result, void *columns) {
+	Q_D(QDuckDBDriver);
+	// only results of this driver are accepted, result may be any QSqlResult
+	const auto found = std::find_if(d->results.cbegin(), d->results.cend(), [result](QDuckDBResult *candidate) {
+		return static_cast<void *>(static_cast<QSqlResult *>(candidate)) == result;
+	});
+	if (!columns || found == d->results.cend()) {
+		setLastError(QSqlError(tr("Unable to fetch columns"), tr("The query does not belong to this driver"),
+		                       QSqlError::StatementError));
+		return false;
+	}
+	QDuckDBResult *source = *found;
+	auto *resultPrivate = source->d_func();
+	auto &stmt = resultPrivate->stmt;
+	if (!source->isActive() || !stmt || !stmt->prepared) {
+		setLastError(QSqlError(tr("Unable to fetch columns"), tr("The query is not executed"),
+		                       QSqlError::StatementError));
+		return false;
+	}
 
-	QString table = tblname;
-	if (isIdentifierEscaped(table, QSqlDriver::TableName))
-		table = stripDelimiters(table, QSqlDriver::TableName);
+	auto &target = *static_cast<QVector<QDuckDBColumn> *>(columns);
+	target.clear();
+	const auto names = stmt->prepared->GetNames();
+	const auto types = stmt->prepared->GetTypes();
+	for (size_t i = 0; i < names.size(); ++i) {
+		QDuckDBColumn column;
+		column.name = QString::fromStdString(names[i]);
+		column.type = qColumnType(types[i], source->numericalPrecisionPolicy());
+		target.append(column);
+	}
+	std::vector<std::vector<uint8_t>> validity(names.size());
+	duckdb::idx_t rows = 0;
+
+	if (stmt->result && stmt->current_chunk) {
+		// the current row was returned by next() unless exec() fetched it ahead
+		duckdb::idx_t offset = 0;
+		if (stmt->current_row && !resultPrivate->skipRow)
+			offset = *stmt->current_row + 1;
+		QueryTimeoutGuard timeoutGuard(*stmt);
+		try {
+			while (stmt->current_chunk && stmt->current_chunk->size() > 0) {
+				auto &chunk = *stmt->current_chunk;
+				if (offset < chunk.size()) {
+					const auto count = chunk.size() - offset;
+					for (duckdb::idx_t i = 0; i < chunk.ColumnCount(); ++i)
+						qAppendColumn(*stmt->context, chunk.data[i], chunk.size(), offset, count,
+						              target[static_cast<qsizetype>(i)], validity[i], rows);
+					rows += count;
+				}
+				offset = 0;
+				duckdb::ErrorData errData;
+				if (!stmt->result->TryFetch(stmt->current_chunk, errData)) {
+					const bool timedOut = timeoutGuard.release();
+					setLastError(qMakeError(
+					    errData,
+					    timedOut ? QCoreApplication::translate("QDuckDBResult", "Query timeout exceeded.")
+					             : tr("Unable to fetch columns"),
+					    QSqlError::StatementError));
+					return false;
+				}
+			}
+		} catch (std::exception &ex) {
+			auto errData = duckdb::ErrorData(ex);
+			setLastError(qMakeError(errData, tr("Unable to fetch columns"), QSqlError::StatementError));
+			return false;
+		}
+	}
 
-	QSqlQuery q(createResult());
-	q.setForwardOnly(true);
-	return qGetTableInfo(q, table, true);
+	for (qsizetype i = 0; i < target.size(); ++i) {
+		auto &column = target[i];
+		column.integers.squeeze();
+		column.reals.squeeze();
+		const auto &bits = validity[static_cast<size_t>(i)];
+		column.valid = QBitArray::fromBits(reinterpret_cast<const char *>(bits.data()), static_cast<qsizetype>(rows));
+	}
+	// the rows are consumed, the query is after its last row like at the end of next()
+	stmt->result.reset();
+	stmt->current_chunk.reset();
+	stmt->current_row.reset();
+	resultPrivate->skipRow = false;
+	source->setAt(QSql::AfterLastRow);
+	return true;
 }
 
-QSqlRecord QDuckDBDriver::record(const QString &tbl) const {
-	if (!isOpen())
-		return QSqlRecord();
-
-	QString table = tbl;
-	if (isIdentifierEscaped(table, QSqlDriver::TableName))
-		table = stripDelimiters(table, QSqlDriver::TableName);
+void QDuckDBDriver::invalidateMetadataCache() {
+	Q_D(QDuckDBDriver);
+	d->invalidateMetadataCache();
+}
 
-	QSqlQuery q(createResult());
-	q.setForwardOnly(true);
-	return qGetTableInfo(q, table);
+void QDuckDBDriver::setInterruptCheck(void *check) {
+	Q_D(QDuckDBDriver);
+	if (check)
+		d->interruptCheck = *static_cast<std::function<bool()> *>(check);
+	else
+		d->interruptCheck = nullptr;
 }
 
 QVariant QDuckDBDriver::handle() const {
 	Q_D(const QDuckDBDriver);
-	if (!d->access) {
+	QSqlError error;
+	if (!isOpen() || !const_cast<QDuckDBDriverPrivate *>(d)->ensureAccess(error)) {
 		return QVariant::fromValue(DuckDBConnectionHandle {});
 	}
 
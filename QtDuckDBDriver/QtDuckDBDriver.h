@@ -6,6 +6,9 @@
 namespace duckdb {
 class DuckDB;
 class Connection;
+class PreparedStatement;
+class QueryResult;
+class DataChunk;
 } // namespace duckdb
 
 struct DuckDBConnectionHandle {
@@ -13,6 +16,23 @@ struct DuckDBConnectionHandle {
 	duckdb::Connection *connection = nullptr;
 };
 
+/// returned by QSqlResult::handle() of a query, e.g. query.result()->handle().value<DuckDBResultHandle>().
+/// The pointers belong to the query and are valid until it fetches, executes or finishes again. Read them only,
+/// fetching from result directly would skip rows of the query.
+///
+/// chunk holds the row last fetched from DuckDB at index row. That is the current row of a forward-only query
+/// positioned with next() or seek(), so a hot loop can read the rest of the chunk in place and then skip those rows
+/// with query.seek(count, true), which does not convert the skipped values.
+struct DuckDBResultHandle {
+	duckdb::PreparedStatement *prepared = nullptr;
+	/// streaming result, nullptr before execution and after the last row
+	duckdb::QueryResult *result = nullptr;
+	duckdb::DataChunk *chunk = nullptr;
+	quint64 row = 0;
+	/// cardinality estimate of the prepared plan, -1 if there is none
+	qlonglong estimatedRows = -1;
+};
+
 #ifdef QT_PLUGIN
 #define Q_EXPORT_SQLDRIVER_DUCKDB
 #else
@@ -22,6 +42,7 @@ struct DuckDBConnectionHandle {
 class QDuckDBDriverPrivate;
 
 class Q_EXPORT_SQLDRIVER_DUCKDB QDuckDBDriver : public QSqlDriver {
+	Q_OBJECT
 	Q_DECLARE_PRIVATE(QDuckDBDriver)
 	friend class QDuckDBResultPrivate;
 
@@ -32,6 +53,8 @@ public:
 	bool open(const QString &db, const QString &user, const QString &password, const QString &host, int port,
 	          const QString &connOpts) override;
 	void close() override;
+	/// interrupts the running statement, can be called from any thread
+	bool cancelQuery() override;
 	QSqlResult *createResult() const override;
 	bool beginTransaction() override;
 	bool commitTransaction() override;
@@ -43,6 +66,87 @@ public:
 	/// returns a DuckDBConnectionHandle
 	QVariant handle() const override;
 	QString escapeIdentifier(const QString &identifier, IdentifierType) const override;
+	/// fetches record() and primaryIndex() of all tables with a single query and caches them,
+	/// e.g. before creating many QSqlTableModels. Tables may be qualified as schema.table or catalog.schema.table.
+	/// Call with QMetaObject::invokeMethod(driver, "prefetchMetadata", Q_RETURN_ARG(bool, ok),
+	/// Q_ARG(QStringList, tables)) when not linking against the plugin.
+	Q_INVOKABLE bool prefetchMetadata(const QStringList &tables);
+	/// estimated number of rows of query with the positional params, from the cardinality estimate of its plan.
+	/// Returns -1 if DuckDB has no estimate. Nothing is executed, so it returns immediately even for large results.
+	/// See QDuckDBRowCount.h for a helper which works without linking against the plugin.
+	Q_INVOKABLE qlonglong estimateRowCount(const QString &query, const QVariantList &params) const;
+	/// estimated number of rows of result, a prepared or executed QSqlResult of this driver, from the plan of its
+	/// prepared statement. Nothing is planned again, so the estimate is the one of the statement the result holds.
+	Q_INVOKABLE qlonglong estimateResultRowCount(void *result) const;
+	/// executes query with the positional params and moves its result into stream, an ArrowArrayStream of the
+	/// Arrow C stream interface. The caller releases the stream. The rows are streamed from the connection,
+	/// consume the stream before executing the next statement, including those of models or the metadata cache.
+	/// Once another statement closed the result, get_next() fails with EIO. See QDuckDBArrow.h for a helper which
+	/// works without linking against the plugin.
+	Q_INVOKABLE bool exportArrowStream(const QString &query, const QVariantList &params, void *stream);
+	/// like exportArrowStream(), executes the prepared statement of result, a QSqlResult of this driver,
+	/// with its bound values
+	Q_INVOKABLE bool exportResultArrowStream(void *result, void *stream);
+	/// registers stream, an ArrowArrayStream, as the temporary view name which scans its buffers in place,
+	/// e.g. for "INSERT INTO t SELECT * FROM name". The driver takes the stream over if it succeeds and releases it
+	/// in unregisterArrowStream() or close(). A stream can only be read once, so can the view.
+	Q_INVOKABLE bool registerArrowStream(const QString &name, void *stream);
+	/// drops the view of registerArrowStream() and releases its stream
+	Q_INVOKABLE bool unregisterArrowStream(const QString &name);
+	/// inserts all rows of stream into table, or creates table from them, with one statement.
+	/// Returns the number of rows or -1 on errors. The stream is released.
+	Q_INVOKABLE qlonglong ingestArrowStream(const QString &table, void *stream, bool create);
+	/// registers model, a QAbstractItemModel, as the temporary view name backed by the table function qt_source(name).
+	/// Column names are the horizontal headers, column types follow the values of the first row (Qt::EditRole).
+	/// Models are not thread-safe, so right before each execution of a statement using the view, all rows of the
+	/// columns it references are fetched and copied on the executing thread, which must be the thread of model.
+	/// DuckDB's threads only scan the copy, so a statement sees the rows of the model when it started.
+	Q_INVOKABLE bool registerModel(const QString &name, QObject *model);
+	/// registers rows of fixed-width columns like registerModel(). Each column is a QVariantMap with "name",
+	/// "type" (BOOLEAN, TINYINT to UBIGINT, FLOAT or DOUBLE), "data" (address of the first value) and "stride"
+	/// (bytes between two values). Contiguous columns are scanned without copying. The memory must stay valid until
+	/// unregisterSource(). See QDuckDBTableFunction.h for helpers.
+	Q_INVOKABLE bool registerColumns(const QString &name, qlonglong rows, const QVariantList &columns);
+	/// drops the view of registerModel() or registerColumns()
+	Q_INVOKABLE bool unregisterSource(const QString &name);
+	/// executes query with the positional params as COPY (query) TO ... (FORMAT format, options) and writes the
+	/// file DuckDB encodes to device, a QIODevice open for writing, while the statement runs. format is csv, json
+	/// or parquet, other formats are rejected. options are further COPY options like "HEADER false", they are
+	/// inserted into the statement as SQL like query, so pass trusted text only. DuckDB's writers wait while the
+	/// device falls behind. Emits queryProgress() like a statement. Blocks the calling thread, which writes to the
+	/// device, until the export finished, so a GUI should export from a worker thread which owns the device.
+	/// Returns the number of bytes written or -1 on errors. See QDuckDBExport.h for a helper which works without
+	/// linking against the plugin.
+	Q_INVOKABLE qlonglong exportToDevice(const QString &query, const QVariantList &params, QObject *device,
+	                                     const QString &format, const QString &options);
+	/// makes data readable by queries of this connection as the file qtbuffer://name, e.g.
+	/// "SELECT * FROM read_parquet('qtbuffer://name')". The bytes are shared with data, not copied.
+	/// Registering a name again replaces its buffer. Qt resources are readable as ":/path" or "qrc:/path".
+	Q_INVOKABLE bool registerBuffer(const QString &name, const QByteArray &data);
+	/// removes the buffer of registerBuffer()
+	Q_INVOKABLE bool unregisterBuffer(const QString &name);
+	/// registers definition, a QDuckDBFunctionDefinition, as a scalar or aggregate function on the instance.
+	/// Scalar functions are called with flat arrays of up to a vector of rows, aggregates with the arrays of the rows
+	/// of one group. See QDuckDBFunction.h for typed helpers.
+	Q_INVOKABLE bool registerFunction(void *definition);
+	/// moves the rows of result, an executed QSqlResult of this driver, which were not fetched yet into columns, a
+	/// QVector<QDuckDBColumn>, converting whole vectors instead of single values. result is after its last row
+	/// afterwards. See QDuckDBColumns.h for a helper which works without linking against the plugin.
+	Q_INVOKABLE bool fetchColumns(void *result, void *columns);
+	/// drops the cached results of record(), primaryIndex() and tables().
+	/// Statements executed through this driver invalidate it when they change the schema, call it after
+	/// changing the schema through another connection or the raw handle.
+	/// Call with QMetaObject::invokeMethod(driver, "invalidateMetadataCache") when not linking against the plugin.
+	Q_INVOKABLE void invalidateMetadataCache();
+	/// check, a std::function<bool()> which is copied, is called on the executing thread between the tasks of each
+	/// statement, which is interrupted as soon as it returns true. nullptr removes it. Used by QDuckDBAsync.h.
+	Q_INVOKABLE void setInterruptCheck(void *check);
+
+Q_SIGNALS:
+	/// emitted while a statement executes or fetches, at most every PROGRESS_INTERVAL_MS milliseconds.
+	/// Connect with SIGNAL(queryProgress(double,qulonglong,qulonglong)) when not linking against the plugin.
+	void queryProgress(double percentage, qulonglong rowsProcessed, qulonglong totalRowsToProcess);
 };
 
-Q_DECLARE_METATYPE(DuckDBConnectionHandle)
\ No newline at end of file
+Q_DECLARE_METATYPE(DuckDBConnectionHandle)
+Q_DECLARE_METATYPE(DuckDBResultHandle)
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <vector>
+
+// Measures the time from QSqlDatabase::open() until the first row of a query is available.
+// Run it from the build directory, the driver is copied next to the executable.
+
+static constexpr int RUNS = 20;
+
+struct Scenario {
+	const char *name;
+	bool file;
+	const char *options;
+};
+
+static qint64 openAndQuery(const QString &path, const QString &options, const QString &connectionName) {
+	qint64 elapsed = -1;
+	{
+		QSqlDatabase db = QSqlDatabase::addDatabase("DUCKDB", connectionName);
+		db.setDatabaseName(path);
+		db.setConnectOptions(options);
+
+		QElapsedTimer timer;
+		timer.start();
+		if (db.open()) {
+			QSqlQuery query(db);
+			if (query.exec("SELECT 42") && query.next())
+				elapsed = timer.nsecsElapsed();
+		}
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+	return elapsed;
+}
+
+int main(int argc, char *argv[]) {
+	QCoreApplication app(argc, argv);
+	QCoreApplication::addLibraryPath(QCoreApplication::applicationDirPath() + "/plugins/");
+	QTextStream out(stdout);
+
+	QTemporaryDir dir;
+	if (!dir.isValid()) {
+		out << "Unable to create a temporary directory\n";
+		return 1;
+	}
+
+	// the first addDatabase loads the plugin, which includes the static initialization of DuckDB
+	QElapsedTimer pluginTimer;
+	pluginTimer.start();
+	QSqlDatabase::addDatabase("DUCKDB", "plugin_load");
+	const qint64 pluginLoad = pluginTimer.nsecsElapsed();
+	QSqlDatabase::removeDatabase("plugin_load");
+	out << "plugin load: " << pluginLoad / 1000 << " us\n";
+
+	const Scenario scenarios[] = {
+	    {"memory", false, ""},
+	    {"memory, LAZY_OPEN", false, "LAZY_OPEN"},
+	    {"memory, DEFER_EXTENSIONS", false, "DEFER_EXTENSIONS=autocomplete,parquet"},
+	    {"file", true, ""},
+	    {"file, LAZY_OPEN", true, "LAZY_OPEN"},
+	    {"file, DEFER_EXTENSIONS", true, "DEFER_EXTENSIONS=autocomplete,parquet"},
+	};
+
+	int run = 0;
+	for (const auto &scenario : scenarios) {
+		std::vector<qint64> samples;
+		for (int i = 0; i < RUNS; ++i) {
+			const QString path = scenario.file ? dir.filePath(QStringLiteral("bench_%1.db").arg(run)) : QString();
+			const qint64 elapsed =
+			    openAndQuery(path, QString::fromLatin1(scenario.options), QStringLiteral("bench_%1").arg(run++));
+			if (elapsed < 0) {
+				out << scenario.name << ": failed\n";
+				return 1;
+			}
+			samples.push_back(elapsed);
+		}
+		std::sort(samples.begin(), samples.end());
+		out << scenario.name << ": median " << samples[samples.size() / 2] / 1000 << " us, min "
+		    << samples.front() / 1000 << " us, max " << samples.back() / 1000 << " us\n";
+	}
+	return 0;
+}
@@ -1,13 +1,23 @@
 #include <QCoreApplication>
 #include <QTest>
 
+#include "qttest/arrow_test.h"
+#include "qttest/async_test.h"
+#include "qttest/cancel_query_test.h"
+#include "qttest/columns_test.h"
 #include "qttest/error_handling_test.h"
+#include "qttest/export_test.h"
 #include "qttest/features_test.h"
+#include "qttest/file_system_test.h"
+#include "qttest/function_test.h"
 #include "qttest/model_test.h"
 #include "qttest/prepared_statements_test.h"
+#include "qttest/progress_test.h"
 #include "qttest/query_execution_test.h"
 #include "qttest/raw_handle_test.h"
 #include "qttest/schema_test.h"
+#include "qttest/shared_instance_test.h"
+#include "qttest/typed_query_test.h"
 
 int main(int argc, char *argv[]) {
 	QCoreApplication app(argc, argv);
@@ -43,6 +53,46 @@ int main(int argc, char *argv[]) {
 		ErrorHandlingTest test;
 		failures += QTest::qExec(&test, argc, argv);
 	}
+	{
+		SharedInstanceTest test;
+		failures += QTest::qExec(&test, argc, argv);
+	}
+	{
+		AsyncTest test;
+		failures += QTest::qExec(&test, argc, argv);
+	}
+	{
+		CancelQueryTest test;
+		failures += QTest::qExec(&test, argc, argv);
+	}
+	{
+		ProgressTest test;
+		failures += QTest::qExec(&test, argc, argv);
+	}
+	{
+		ArrowTest test;
+		failures += QTest::qExec(&test, argc, argv);
+	}
+	{
+		ExportTest test;
+		failures += QTest::qExec(&test, argc, argv);
+	}
+	{
+		FileSystemTest test;
+		failures += QTest::qExec(&test, argc, argv);
+	}
+	{
+		FunctionTest test;
+		failures += QTest::qExec(&test, argc, argv);
+	}
+	{
+		ColumnsTest test;
+		failures += QTest::qExec(&test, argc, argv);
+	}
+	{
+		TypedQueryTest test;
+		failures += QTest::qExec(&test, argc, argv);
+	}
 
 	return failures;
 }
@@ -0,0 +1,2 @@
+#include "arrow_test.h"
+#include "moc_arrow_test.cpp"
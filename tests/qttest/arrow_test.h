@@ -0,0 +1,169 @@
+#pragma once
+
+#include "../../QtDuckDBDriver/QDuckDBArrow.h"
+#include "../helpers/test_database.h"
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTest>
+#include <cerrno>
+
+class ArrowTest : public QObject {
+	Q_OBJECT
+
+	// reads all batches of the stream and releases it, sums up the first column if it is a BIGINT column
+	static void consume(ArrowArrayStream &stream, int64_t &rows, int64_t &sum) {
+		rows = 0;
+		sum = 0;
+		for (;;) {
+			ArrowArray batch {};
+			QCOMPARE(stream.get_next(&stream, &batch), 0);
+			if (!batch.release)
+				break;
+			const ArrowArray *column = batch.children[0];
+			const auto *values = static_cast<const int64_t *>(column->buffers[1]);
+			for (int64_t i = 0; i < column->length; ++i)
+				sum += values[column->offset + i];
+			rows += batch.length;
+			batch.release(&batch);
+		}
+		stream.release(&stream);
+	}
+
+private slots:
+	void exportQuery() {
+		TestDatabase db;
+		db.exec("CREATE TABLE measurements AS SELECT i AS id, i * 0.5 AS value, 'row' || i AS label FROM range(5000) t(i)");
+
+		ArrowArrayStream stream {};
+		QVERIFY(QDuckDBArrow::exportQuery(db.db(), "SELECT id, value, label FROM measurements WHERE id >= ?", {1000},
+		                                  &stream));
+		ArrowSchema schema {};
+		QCOMPARE(stream.get_schema(&stream, &schema), 0);
+		QCOMPARE(schema.n_children, int64_t(3));
+		QCOMPARE(QByteArray(schema.children[0]->name), QByteArray("id"));
+		QCOMPARE(QByteArray(schema.children[0]->format), QByteArray("l"));
+		QCOMPARE(QByteArray(schema.children[2]->name), QByteArray("label"));
+		schema.release(&schema);
+
+		int64_t rows = 0;
+		int64_t sum = 0;
+		consume(stream, rows, sum);
+		QCOMPARE(rows, int64_t(4000));
+		QCOMPARE(sum, int64_t(11998000));
+
+		// the connection is usable again once the stream is released
+		QSqlQuery query(db.db());
+		QVERIFY(query.exec("SELECT count(*) FROM measurements"));
+		QVERIFY(query.next());
+	}
+
+	void exportPreparedQuery() {
+		TestDatabase db;
+		QSqlQuery query(db.db());
+		QVERIFY(query.prepare("SELECT i FROM range(100) t(i) WHERE i < ?"));
+		query.addBindValue(10);
+
+		ArrowArrayStream stream {};
+		QVERIFY(QDuckDBArrow::exportQuery(query, &stream));
+		int64_t rows = 0;
+		int64_t sum = 0;
+		consume(stream, rows, sum);
+		QCOMPARE(rows, int64_t(10));
+		QCOMPARE(sum, int64_t(45));
+
+		// the query itself is unaffected
+		QVERIFY(query.exec());
+		int count = 0;
+		while (query.next())
+			++count;
+		QCOMPARE(count, 10);
+	}
+
+	void exportErrors() {
+		TestDatabase db;
+		ArrowArrayStream stream {};
+		QVERIFY(!QDuckDBArrow::exportQuery(db.db(), "SELECT * FROM missing_table", &stream));
+		QVERIFY(db.db().lastError().isValid());
+		QVERIFY(!stream.release);
+
+		QSqlQuery unprepared(db.db());
+		QVERIFY(!QDuckDBArrow::exportQuery(unprepared, &stream));
+		QVERIFY(!stream.release);
+	}
+
+	void statementWhileStreamAlive() {
+		TestDatabase db;
+		QSqlQuery query(db.db());
+
+		// more rows than one batch, the second batch is read after the result was closed
+		ArrowArrayStream stream {};
+		QVERIFY(QDuckDBArrow::exportQuery(db.db(), "SELECT i FROM range(2500000) t(i)", &stream));
+		ArrowArray batch {};
+		QCOMPARE(stream.get_next(&stream, &batch), 0);
+		QVERIFY(batch.release);
+		batch.release(&batch);
+		QVERIFY(query.exec("SELECT 42"));
+		QVERIFY(query.next());
+		QCOMPARE(stream.get_next(&stream, &batch), EIO);
+		QVERIFY(!batch.release);
+		QVERIFY(QByteArray(stream.get_last_error(&stream)).contains("closed"));
+		stream.release(&stream);
+
+		// a result which was read completely still ends regularly
+		QVERIFY(QDuckDBArrow::exportQuery(db.db(), "SELECT i FROM range(10) t(i)", &stream));
+		QCOMPARE(stream.get_next(&stream, &batch), 0);
+		QCOMPARE(batch.length, int64_t(10));
+		batch.release(&batch);
+		QVERIFY(query.exec("SELECT 42"));
+		QCOMPARE(stream.get_next(&stream, &batch), 0);
+		QVERIFY(!batch.release);
+		stream.release(&stream);
+	}
+	void registerStream() {
+		TestDatabase source;
+		TestDatabase target;
+		ArrowArrayStream stream {};
+		QVERIFY(QDuckDBArrow::exportQuery(source.db(), "SELECT i AS id, i % 3 AS bucket FROM range(3000) t(i)", &stream));
+		QVERIFY(QDuckDBArrow::registerStream(target.db(), "incoming", &stream));
+		QVERIFY(!stream.release);
+
+		QSqlQuery query(target.db());
+		QVERIFY(query.exec("SELECT bucket, count(*), sum(id) FROM incoming GROUP BY bucket ORDER BY bucket"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toLongLong(), qlonglong(0));
+		QCOMPARE(query.value(1).toLongLong(), qlonglong(1000));
+		QCOMPARE(query.value(2).toLongLong(), qlonglong(1498500));
+		query.finish();
+
+		QVERIFY(QDuckDBArrow::unregisterStream(target.db(), "incoming"));
+		QVERIFY(!query.exec("SELECT * FROM incoming"));
+		QVERIFY(!QDuckDBArrow::unregisterStream(target.db(), "incoming"));
+	}
+
+	void ingestStream() {
+		TestDatabase source;
+		TestDatabase target;
+		ArrowArrayStream stream {};
+		QVERIFY(QDuckDBArrow::exportQuery(source.db(), "SELECT i AS id, 'name' || i AS name FROM range(2500) t(i)",
+		                                  &stream));
+		QCOMPARE(QDuckDBArrow::ingest(target.db(), "people", &stream, QDuckDBArrow::IngestMode::Create),
+		         qlonglong(2500));
+		QVERIFY(!stream.release);
+
+		QVERIFY(QDuckDBArrow::exportQuery(source.db(), "SELECT i + 2500, 'name' || i FROM range(500) t(i)", &stream));
+		QCOMPARE(QDuckDBArrow::ingest(target.db(), "people", &stream), qlonglong(500));
+
+		QSqlQuery query(target.db());
+		QVERIFY(query.exec("SELECT count(*), max(id), min(name) FROM people"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toLongLong(), qlonglong(3000));
+		QCOMPARE(query.value(1).toLongLong(), qlonglong(2999));
+		QCOMPARE(query.value(2).toString(), QString("name0"));
+
+		// the stream is released even if the table does not exist
+		QVERIFY(QDuckDBArrow::exportQuery(source.db(), "SELECT 1", &stream));
+		QCOMPARE(QDuckDBArrow::ingest(target.db(), "missing_table", &stream), qlonglong(-1));
+		QVERIFY(target.db().lastError().isValid());
+		QVERIFY(!stream.release);
+	}
+};
@@ -0,0 +1,2 @@
+#include "async_test.h"
+#include "moc_async_test.cpp"
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "../../QtDuckDBDriver/QDuckDBAsync.h"
+#include "../helpers/test_database.h"
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTest>
+#include <QThread>
+
+class AsyncTest : public QObject {
+	Q_OBJECT
+
+private:
+	static QSqlDatabase openShared(const QString &name) {
+		QSqlDatabase db = QSqlDatabase::addDatabase("DUCKDB", name);
+		db.setDatabaseName(":memory:" + name);
+		db.setConnectOptions("SHARED_INSTANCE");
+		db.open();
+		return db;
+	}
+
+private slots:
+	void execReturnsRows() {
+		{
+			QSqlDatabase db = openShared("async_rows");
+			QVERIFY2(db.isOpen(), qPrintable(db.lastError().text()));
+			QSqlQuery q(db);
+			QVERIFY(q.exec("CREATE TABLE items AS SELECT range AS id, 'item_' || range AS name FROM range(100)"));
+
+			auto future = QDuckDBAsync::exec(db, "SELECT id, name FROM items WHERE id >= ? ORDER BY id", {90});
+			future.waitForFinished();
+			auto result = future.result();
+			QVERIFY2(!result.error.isValid(), qPrintable(result.error.text()));
+			QCOMPARE(result.record.count(), 2);
+			QCOMPARE(result.record.fieldName(1), "name");
+			QCOMPARE(result.rows.size(), 10);
+			QCOMPARE(result.rows.first().at(0).toInt(), 90);
+			QCOMPARE(result.rows.last().at(1).toString(), "item_99");
+		}
+		QSqlDatabase::removeDatabase("async_rows");
+	}
+
+	void execPropagatesError() {
+		{
+			QSqlDatabase db = openShared("async_error");
+			QVERIFY2(db.isOpen(), qPrintable(db.lastError().text()));
+
+			auto future = QDuckDBAsync::exec(db, "SELECT * FROM nonexistent_table");
+			future.waitForFinished();
+			QVERIFY(future.result().error.isValid());
+		}
+		QSqlDatabase::removeDatabase("async_error");
+	}
+
+	void execRequiresSharedInstance() {
+		TestDatabase db;
+		auto future = QDuckDBAsync::exec(db.db(), "SELECT 1");
+		future.waitForFinished();
+		QVERIFY(future.result().error.isValid());
+	}
+
+	void cancelInterruptsQuery() {
+		{
+			QSqlDatabase db = openShared("async_cancel");
+			QVERIFY2(db.isOpen(), qPrintable(db.lastError().text()));
+
+			auto future =
+			    QDuckDBAsync::exec(db, "SELECT SUM(a.range * b.range) FROM range(1000000) a, range(1000000) b");
+			QTest::qWait(200);
+			future.cancel();
+			QTRY_VERIFY_WITH_TIMEOUT(future.isFinished(), 30000);
+			QVERIFY(future.isCanceled());
+		}
+		QSqlDatabase::removeDatabase("async_cancel");
+	}
+
+	void cancelWithoutEventLoop() {
+		{
+			QSqlDatabase db = openShared("async_cancel_blocking");
+			QVERIFY2(db.isOpen(), qPrintable(db.lastError().text()));
+
+			// neither waiting nor cancelling processes events of this thread
+			QElapsedTimer timer;
+			timer.start();
+			auto future =
+			    QDuckDBAsync::exec(db, "SELECT SUM(a.range * b.range) FROM range(1000000) a, range(1000000) b");
+			QThread::msleep(200);
+			future.cancel();
+			future.waitForFinished();
+			QVERIFY(future.isCanceled());
+			QVERIFY(timer.elapsed() < 30000);
+		}
+		QSqlDatabase::removeDatabase("async_cancel_blocking");
+	}
+};
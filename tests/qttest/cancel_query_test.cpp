@@ -0,0 +1,2 @@
+#include "cancel_query_test.h"
+#include "moc_cancel_query_test.cpp"
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../helpers/test_database.h"
+#include <QElapsedTimer>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTest>
+#include <QThread>
+
+// runs long enough to only finish when interrupted
+static const char *const LONG_RUNNING_QUERY = "SELECT SUM(a.range * b.range) FROM range(1000000) a, range(1000000) b";
+
+class CancelQueryTest : public QObject {
+	Q_OBJECT
+
+private slots:
+	void cancelFeature() {
+		TestDatabase db;
+		QVERIFY(db.db().driver()->hasFeature(QSqlDriver::CancelQuery));
+	}
+
+	void cancelFromOtherThread() {
+		TestDatabase db;
+		QSqlDriver *driver = db.db().driver();
+		QThread *canceller = QThread::create([driver]() {
+			QThread::msleep(200);
+			driver->cancelQuery();
+		});
+		canceller->start();
+
+		QSqlQuery q(db.db());
+		QVERIFY(!q.exec(LONG_RUNNING_QUERY));
+		QVERIFY(q.lastError().isValid());
+		QVERIFY(canceller->wait(30000));
+		delete canceller;
+
+		// the connection is usable after the interruption
+		QVERIFY(q.exec("SELECT 1"));
+		QVERIFY(q.next());
+		QCOMPARE(q.value(0).toInt(), 1);
+	}
+
+	void connectionTimeout() {
+		{
+			QSqlDatabase db = QSqlDatabase::addDatabase("DUCKDB", "timeout_connection");
+			db.setConnectOptions("QUERY_TIMEOUT_MS=200");
+			QVERIFY2(db.open(), qPrintable(db.lastError().text()));
+
+			QElapsedTimer timer;
+			timer.start();
+			QSqlQuery q(db);
+			QVERIFY(!q.exec(LONG_RUNNING_QUERY));
+			QVERIFY(q.lastError().text().contains("timeout"));
+			QVERIFY(timer.elapsed() < 30000);
+
+			QVERIFY(q.exec("SELECT 1"));
+			QVERIFY(q.next());
+		}
+		QSqlDatabase::removeDatabase("timeout_connection");
+	}
+
+	void sessionTimeoutSetting() {
+		TestDatabase db;
+		QSqlQuery q(db.db());
+		QVERIFY(q.exec("SET qtduckdb_query_timeout_ms = 200"));
+		QVERIFY(!q.exec(LONG_RUNNING_QUERY));
+		QVERIFY(q.lastError().text().contains("timeout"));
+
+		QVERIFY(q.exec("RESET qtduckdb_query_timeout_ms"));
+		QVERIFY(q.exec("SELECT 42"));
+		QVERIFY(q.next());
+		QCOMPARE(q.value(0).toInt(), 42);
+	}
+
+	void invalidTimeoutOption() {
+		{
+			QSqlDatabase db = QSqlDatabase::addDatabase("DUCKDB", "timeout_invalid");
+			db.setConnectOptions("QUERY_TIMEOUT_MS=soon");
+			QVERIFY(!db.open());
+			QVERIFY(db.lastError().isValid());
+		}
+		QSqlDatabase::removeDatabase("timeout_invalid");
+	}
+};
@@ -0,0 +1,2 @@
+#include "columns_test.h"
+#include "moc_columns_test.cpp"
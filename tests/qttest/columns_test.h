@@ -0,0 +1,124 @@
+#pragma once
+
+#include "../../QtDuckDBDriver/QDuckDBColumns.h"
+#include "../helpers/test_database.h"
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTest>
+
+class ColumnsTest : public QObject {
+	Q_OBJECT
+
+private slots:
+	void fetchAll() {
+		TestDatabase db;
+		QSqlQuery query(db.db());
+		query.setForwardOnly(true);
+		QVERIFY(query.exec("SELECT i AS id, i * 0.5 AS half, 'row' || i AS label, "
+		                   "CASE WHEN i % 10 = 0 THEN NULL ELSE i::INTEGER END AS sparse, i % 2 = 0 AS even "
+		                   "FROM range(5000) t(i) ORDER BY i"));
+
+		QVector<QDuckDBColumn> columns;
+		QVERIFY2(QDuckDBColumns::fetch(query, columns), qPrintable(db.db().driver()->lastError().text()));
+		QCOMPARE(columns.size(), 5);
+		QCOMPARE(columns[0].name, QString("id"));
+		QCOMPARE(columns[0].type, QDuckDBColumn::Integer);
+		QCOMPARE(columns[1].type, QDuckDBColumn::Real);
+		QCOMPARE(columns[2].type, QDuckDBColumn::Text);
+		QCOMPARE(columns[3].type, QDuckDBColumn::Integer);
+		QCOMPARE(columns[4].type, QDuckDBColumn::Integer);
+		for (const auto &column : columns)
+			QCOMPARE(column.size(), qsizetype(5000));
+
+		QCOMPARE(columns[0].integers.size(), 5000);
+		QCOMPARE(columns[0].integers[4321], qint64(4321));
+		QCOMPARE(columns[1].reals[4321], 2160.5);
+		QCOMPARE(columns[2].texts[4321], QString("row4321"));
+		QCOMPARE(columns[4].integers[4320], qint64(1));
+		QVERIFY(!columns[3].valid.testBit(4320));
+		QCOMPARE(columns[3].integers[4320], qint64(0));
+		QVERIFY(columns[3].valid.testBit(4321));
+		QCOMPARE(columns[3].integers[4321], qint64(4321));
+		QCOMPARE(columns[3].valid.count(true), 4500);
+
+		// the query is after its last row
+		QVERIFY(!query.next());
+		QVERIFY(query.exec("SELECT 1"));
+		QVERIFY(query.next());
+	}
+
+	void exactWideIntegers() {
+		TestDatabase db;
+		QSqlQuery query(db.db());
+		query.setForwardOnly(true);
+		QVERIFY(query.exec("SELECT 18446744073709551615::UBIGINT AS u, "
+		                   "170141183460469231731687303715884105727::HUGEINT AS h, 9007199254740993 AS b"));
+
+		QVector<QDuckDBColumn> columns;
+		QVERIFY(QDuckDBColumns::fetch(query, columns));
+		QCOMPARE(columns[0].type, QDuckDBColumn::Text);
+		QCOMPARE(columns[0].texts[0], QString("18446744073709551615"));
+		QCOMPARE(columns[1].type, QDuckDBColumn::Text);
+		QCOMPARE(columns[1].texts[0], QString("170141183460469231731687303715884105727"));
+		QCOMPARE(columns[2].type, QDuckDBColumn::Integer);
+		QCOMPARE(columns[2].integers[0], qint64(9007199254740993));
+	}
+
+	void precisionPolicy() {
+		TestDatabase db;
+		QSqlQuery query(db.db());
+		query.setForwardOnly(true);
+		const QString sql("SELECT 12345678901234567890.0123456789::DECIMAL(38, 10) AS d, 2.5::DOUBLE AS f");
+
+		// DECIMAL is exact with QSql::HighPrecision, like the values of next()
+		query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+		QVERIFY(query.exec(sql));
+		QVector<QDuckDBColumn> columns;
+		QVERIFY(QDuckDBColumns::fetch(query, columns));
+		QCOMPARE(columns[0].type, QDuckDBColumn::Text);
+		QCOMPARE(columns[0].texts[0], QString("12345678901234567890.0123456789"));
+		QCOMPARE(columns[1].type, QDuckDBColumn::Real);
+		QCOMPARE(columns[1].reals[0], 2.5);
+
+		query.setNumericalPrecisionPolicy(QSql::LowPrecisionInt64);
+		QVERIFY(query.exec("SELECT 2.5::DOUBLE AS f"));
+		QVERIFY(QDuckDBColumns::fetch(query, columns));
+		QCOMPARE(columns[0].type, QDuckDBColumn::Integer);
+		QVERIFY(query.exec("SELECT 2.5::DOUBLE AS f"));
+		QVERIFY(query.next());
+		QCOMPARE(columns[0].integers[0], query.value(0).toLongLong());
+	}
+
+	void fetchRemaining() {
+		TestDatabase db;
+		QSqlQuery query(db.db());
+		query.setForwardOnly(true);
+		QVERIFY(query.exec("SELECT i FROM range(3000) t(i) ORDER BY i"));
+		QVERIFY(query.next());
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toLongLong(), qlonglong(1));
+
+		QVector<QDuckDBColumn> columns;
+		QVERIFY(QDuckDBColumns::fetch(query, columns));
+		QCOMPARE(columns[0].size(), qsizetype(2998));
+		QCOMPARE(columns[0].integers.first(), qint64(2));
+		QCOMPARE(columns[0].integers.last(), qint64(2999));
+
+		// nothing remains
+		QVERIFY(QDuckDBColumns::fetch(query, columns));
+		QCOMPARE(columns.size(), 1);
+		QCOMPARE(columns[0].size(), qsizetype(0));
+	}
+
+	void fetchErrors() {
+		TestDatabase db;
+		QSqlQuery query(db.db());
+		QVector<QDuckDBColumn> columns;
+		QVERIFY(query.prepare("SELECT 1"));
+		QVERIFY(!QDuckDBColumns::fetch(query, columns));
+
+		QVERIFY(query.exec("SELECT 1 WHERE false"));
+		QVERIFY(QDuckDBColumns::fetch(query, columns));
+		QCOMPARE(columns[0].size(), qsizetype(0));
+	}
+};
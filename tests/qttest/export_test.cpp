@@ -0,0 +1,2 @@
+#include "export_test.h"
+#include "moc_export_test.cpp"
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../../QtDuckDBDriver/QDuckDBExport.h"
+#include "../helpers/test_database.h"
+#include <QBuffer>
+#include <QFile>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTest>
+
+class ExportTest : public QObject {
+	Q_OBJECT
+
+private slots:
+	void csvToBuffer() {
+		TestDatabase db;
+		db.exec("CREATE TABLE measurements AS SELECT i AS id, i * 0.5 AS value FROM range(1000) t(i)");
+
+		QBuffer buffer;
+		QVERIFY(buffer.open(QIODevice::WriteOnly));
+		const qlonglong bytes = QDuckDBExport::toDevice(
+		    db.db(), "SELECT id, value FROM measurements WHERE id < ? ORDER BY id", {3}, &buffer);
+		QCOMPARE(bytes, qlonglong(buffer.size()));
+		QCOMPARE(buffer.data(), QByteArray("id,value\n0,0.0\n1,0.5\n2,1.0\n"));
+
+		buffer.buffer().clear();
+		buffer.seek(0);
+		QVERIFY(QDuckDBExport::toDevice(db.db(), "SELECT id FROM measurements WHERE id < 2 ORDER BY id", &buffer,
+		                                QDuckDBExport::Format::Csv, "HEADER false") > 0);
+		QCOMPARE(buffer.data(), QByteArray("0\n1\n"));
+	}
+
+	void preparedQuery() {
+		TestDatabase db;
+		QSqlQuery query(db.db());
+		QVERIFY(query.prepare("SELECT ? AS answer"));
+		query.addBindValue(42);
+
+		QBuffer buffer;
+		QVERIFY(buffer.open(QIODevice::WriteOnly));
+		QVERIFY(QDuckDBExport::toDevice(query, &buffer) > 0);
+		QCOMPARE(buffer.data(), QByteArray("answer\n42\n"));
+	}
+
+	void largeExportRoundTrip() {
+		// more than the bytes queued for the device, so DuckDB's writers have to wait for it
+		TestDatabase db;
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		const QString path = dir.filePath("export.csv");
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		const qlonglong bytes = QDuckDBExport::toDevice(
+		    db.db(), "SELECT i AS id, 'label ' || i AS label FROM range(2000000) t(i)", &file);
+		file.close();
+		QVERIFY(bytes > 16 * 1024 * 1024);
+		QCOMPARE(bytes, qlonglong(file.size()));
+
+		QSqlQuery query(db.db());
+		QVERIFY(query.exec(QString("SELECT count(*), sum(id) FROM read_csv('%1')").arg(path)));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toLongLong(), qlonglong(2000000));
+		QCOMPARE(query.value(1).toLongLong(), qlonglong(1999999000000));
+	}
+
+	void errors() {
+		TestDatabase db;
+		QBuffer buffer;
+		QCOMPARE(QDuckDBExport::toDevice(db.db(), "SELECT 1", &buffer), qlonglong(-1));
+		QVERIFY(db.db().driver()->lastError().isValid());
+
+		QVERIFY(buffer.open(QIODevice::WriteOnly));
+		QCOMPARE(QDuckDBExport::toDevice(db.db(), "SELECT * FROM missing_table", &buffer), qlonglong(-1));
+		QVERIFY(db.db().driver()->lastError().isValid());
+		QCOMPARE(QDuckDBExport::toDevice(db.db(), "SELECT ?", &buffer), qlonglong(-1));
+
+		// only known formats reach the statement
+		qlonglong bytes = 0;
+		QVERIFY(QMetaObject::invokeMethod(db.db().driver(), "exportToDevice", Qt::DirectConnection,
+		                                  Q_RETURN_ARG(qlonglong, bytes), Q_ARG(QString, "SELECT 1"),
+		                                  Q_ARG(QVariantList, QVariantList()), Q_ARG(QObject *, &buffer),
+		                                  Q_ARG(QString, "csv') TO 'x.csv"), Q_ARG(QString, QString())));
+		QCOMPARE(bytes, qlonglong(-1));
+		QCOMPARE(buffer.size(), qint64(0));
+
+		// the connection is usable afterwards
+		QVERIFY(QDuckDBExport::toDevice(db.db(), "SELECT 1 AS one", &buffer) > 0);
+	}
+};
@@ -228,6 +228,84 @@ private slots:
 		QFile::remove(dbName);
 	}
 
+	void dbConfigOptions() {
+		{
+			QSqlDatabase db = QSqlDatabase::addDatabase("DUCKDB", "dbconfig_options");
+			db.setConnectOptions("THREADS=2; MEMORY_LIMIT=512MB; PRESERVE_INSERTION_ORDER=false");
+			QVERIFY2(db.open(), qPrintable(db.lastError().text()));
+
+			QSqlQuery q(db);
+			QVERIFY(q.exec("SELECT current_setting('threads'), current_setting('preserve_insertion_order')"));
+			QVERIFY(q.next());
+			QCOMPARE(q.value(0).toInt(), 2);
+			QCOMPARE(q.value(1).toBool(), false);
+		}
+		QSqlDatabase::removeDatabase("dbconfig_options");
+	}
+
+	void invalidConnectOptions_data() {
+		QTest::addColumn<QString>("options");
+		QTest::newRow("unknown option") << "NO_SUCH_OPTION=1";
+		QTest::newRow("missing value") << "MEMORY_LIMIT=";
+		QTest::newRow("invalid number") << "THREADS=many";
+		QTest::newRow("invalid memory limit") << "MEMORY_LIMIT=lots";
+		QTest::newRow("flag with value") << "READONLY=1";
+		QTest::newRow("unknown deferred extension") << "DEFER_EXTENSIONS=no_such_extension";
+		QTest::newRow("no deferred extension") << "DEFER_EXTENSIONS=,";
+	}
+
+	void invalidConnectOptions() {
+		QFETCH(QString, options);
+		{
+			QSqlDatabase db = QSqlDatabase::addDatabase("DUCKDB", "invalid_options");
+			db.setConnectOptions(options);
+			QVERIFY(!db.open());
+			QCOMPARE(db.lastError().type(), QSqlError::ConnectionError);
+		}
+		QSqlDatabase::removeDatabase("invalid_options");
+	}
+
+	void lazyOpen() {
+		{
+			QSqlDatabase db = QSqlDatabase::addDatabase("DUCKDB", "lazy_open");
+			db.setConnectOptions("LAZY_OPEN");
+			QVERIFY(db.open());
+
+			QSqlQuery q(db);
+			QVERIFY2(q.exec("SELECT 42"), qPrintable(q.lastError().text()));
+			QVERIFY(q.next());
+			QCOMPARE(q.value(0).toInt(), 42);
+		}
+		QSqlDatabase::removeDatabase("lazy_open");
+	}
+
+	void lazyOpenReportsErrorsOnFirstStatement() {
+		{
+			QSqlDatabase db = QSqlDatabase::addDatabase("DUCKDB", "lazy_open_error");
+			db.setDatabaseName("/no/such/directory/lazy.db");
+			db.setConnectOptions("LAZY_OPEN");
+			QVERIFY(db.open());
+
+			QSqlQuery q(db);
+			QVERIFY(!q.exec("SELECT 42"));
+			QCOMPARE(q.lastError().type(), QSqlError::ConnectionError);
+		}
+		QSqlDatabase::removeDatabase("lazy_open_error");
+	}
+
+	void deferredExtensions() {
+		{
+			QSqlDatabase db = QSqlDatabase::addDatabase("DUCKDB", "deferred_extensions");
+			db.setConnectOptions("LAZY_OPEN; DEFER_EXTENSIONS=autocomplete");
+			QVERIFY2(db.open(), qPrintable(db.lastError().text()));
+
+			QSqlQuery q(db);
+			QVERIFY2(q.exec("SELECT * FROM sql_auto_complete('SELECT ci')"), qPrintable(q.lastError().text()));
+			QVERIFY(q.next());
+		}
+		QSqlDatabase::removeDatabase("deferred_extensions");
+	}
+
 	void execBatchInsert() {
 		TestDatabase db;
 		db.exec("CREATE TABLE items (id INTEGER, name VARCHAR)");
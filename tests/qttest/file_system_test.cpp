@@ -0,0 +1,2 @@
+#include "file_system_test.h"
+#include "moc_file_system_test.cpp"
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../../QtDuckDBDriver/QDuckDBBuffer.h"
+#include "../../QtDuckDBDriver/QDuckDBExport.h"
+#include "../helpers/test_database.h"
+#include <QBuffer>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTest>
+
+class FileSystemTest : public QObject {
+	Q_OBJECT
+
+	static QVariant scalar(const QSqlDatabase &db, const QString &sql) {
+		QSqlQuery query(db);
+		if (!query.exec(sql) || !query.next())
+			return QVariant();
+		return query.value(0);
+	}
+
+private slots:
+	void readResource() {
+		TestDatabase db;
+		QCOMPARE(scalar(db.db(), "SELECT sum(price) FROM read_csv(':/data/prices.csv')").toDouble(), 4.0);
+		QCOMPARE(scalar(db.db(), "SELECT count(*) FROM 'qrc:/data/prices.csv'").toLongLong(), qlonglong(3));
+		QCOMPARE(scalar(db.db(), "SELECT count(*) FROM read_csv(':/data/*.csv')").toLongLong(), qlonglong(4));
+
+		QSqlQuery query(db.db());
+		QVERIFY(!query.exec("SELECT * FROM read_csv(':/data/missing.csv')"));
+		QVERIFY(!query.exec("COPY (SELECT 1) TO ':/data/new.csv'"));
+	}
+
+	void readBuffer() {
+		TestDatabase db;
+		QVERIFY(QDuckDBBuffer::registerBuffer(db.db(), "prices.csv", "item,price\napple,1.5\npear,2.0\n"));
+		QCOMPARE(scalar(db.db(), "SELECT sum(price) FROM read_csv('qtbuffer://prices.csv')").toDouble(), 3.5);
+
+		// registering a name again replaces the buffer
+		QVERIFY(QDuckDBBuffer::registerBuffer(db.db(), "prices.csv", "item,price\nplum,0.5\n"));
+		QCOMPARE(scalar(db.db(), "SELECT sum(price) FROM read_csv('qtbuffer://prices.csv')").toDouble(), 0.5);
+
+		// buffers belong to the connection which registered them
+		TestDatabase other;
+		QSqlQuery query(other.db());
+		QVERIFY(!query.exec("SELECT * FROM read_csv('qtbuffer://prices.csv')"));
+
+		QVERIFY(QDuckDBBuffer::unregisterBuffer(db.db(), "prices.csv"));
+		QVERIFY(!QDuckDBBuffer::unregisterBuffer(db.db(), "prices.csv"));
+		QSqlQuery gone(db.db());
+		QVERIFY(!gone.exec("SELECT * FROM read_csv('qtbuffer://prices.csv')"));
+	}
+
+	void readParquetBuffer() {
+		// Parquet reads the footer first and then the row groups at their offsets
+		TestDatabase db;
+		QBuffer buffer;
+		QVERIFY(buffer.open(QIODevice::WriteOnly));
+		if (QDuckDBExport::toDevice(db.db(), "SELECT i AS id FROM range(100000) t(i)", &buffer,
+		                            QDuckDBExport::Format::Parquet, "ROW_GROUP_SIZE 10000") < 0)
+			QSKIP("The parquet extension is not built in");
+
+		QVERIFY(QDuckDBBuffer::registerBuffer(db.db(), "ids.parquet", buffer.data()));
+		QCOMPARE(scalar(db.db(), "SELECT sum(id) FROM read_parquet('qtbuffer://ids.parquet') WHERE id >= 50000")
+		             .toLongLong(),
+		         qlonglong(3749975000));
+	}
+};
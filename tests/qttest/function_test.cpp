@@ -0,0 +1,2 @@
+#include "function_test.h"
+#include "moc_function_test.cpp"
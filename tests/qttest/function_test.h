@@ -0,0 +1,145 @@
+#pragma once
+
+#include "../../QtDuckDBDriver/QDuckDBFunction.h"
+#include "../helpers/test_database.h"
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTest>
+
+class FunctionTest : public QObject {
+	Q_OBJECT
+
+	struct Weighted {
+		double sum = 0;
+		double weights = 0;
+	};
+
+	static bool registerWeightedAverage(const QSqlDatabase &db) {
+		return QDuckDBFunction::registerAggregate<Weighted, double, double, double>(
+		    db, "weighted_avg",
+		    [](Weighted &state, qsizetype rows, const double *value, const double *weight) {
+			    for (qsizetype i = 0; i < rows; ++i) {
+				    state.sum += value[i] * weight[i];
+				    state.weights += weight[i];
+			    }
+		    },
+		    [](Weighted &state, const Weighted &other) {
+			    state.sum += other.sum;
+			    state.weights += other.weights;
+		    },
+		    [](const Weighted &state) { return state.weights == 0 ? 0.0 : state.sum / state.weights; });
+	}
+
+private slots:
+	void scalarFunction() {
+		TestDatabase db;
+		QVERIFY(QDuckDBFunction::registerScalar<double, double>(
+		    db.db(), "fahrenheit", [](qsizetype rows, double *result, const double *celsius) {
+			    for (qsizetype i = 0; i < rows; ++i)
+				    result[i] = celsius[i] * 9 / 5 + 32;
+		    }));
+		QVERIFY(QDuckDBFunction::registerScalar<int64_t, int32_t, int32_t>(
+		    db.db(), "packed", [](qsizetype rows, int64_t *result, const int32_t *high, const int32_t *low) {
+			    for (qsizetype i = 0; i < rows; ++i)
+				    result[i] = (int64_t(high[i]) << 32) | uint32_t(low[i]);
+		    }));
+
+		QSqlQuery query(db.db());
+		QVERIFY(query.exec("SELECT fahrenheit(100), fahrenheit(NULL), packed(1, 2)"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toDouble(), 212.0);
+		QVERIFY(query.value(1).isNull());
+		QCOMPARE(query.value(2).toLongLong(), (qlonglong(1) << 32) | 2);
+
+		// many vectors, evaluated by several threads
+		QVERIFY(query.exec("SELECT sum(fahrenheit(i::DOUBLE)) FROM range(1000000) t(i)"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toDouble(), 999999.0 * 1000000 / 2 * 9 / 5 + 32.0 * 1000000);
+	}
+
+	void aggregateFunction() {
+		TestDatabase db;
+		QVERIFY(registerWeightedAverage(db.db()));
+		db.exec("CREATE TABLE readings AS SELECT i % 3 AS sensor, i::DOUBLE AS value, 1.0::DOUBLE AS weight "
+		        "FROM range(300000) t(i)");
+		db.exec("INSERT INTO readings VALUES (0, NULL, 5), (0, 1000000, NULL)");
+
+		QSqlQuery query(db.db());
+		// rows with a NULL argument are skipped
+		const QString expected = "avg(value) FILTER (WHERE weight IS NOT NULL)";
+		QVERIFY(query.exec("SELECT weighted_avg(value, weight), " + expected + " FROM readings"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toDouble(), query.value(1).toDouble());
+
+		QVERIFY(query.exec("SELECT sensor, weighted_avg(value, weight), " + expected +
+		                   " FROM readings GROUP BY sensor ORDER BY sensor"));
+		int groups = 0;
+		while (query.next()) {
+			QCOMPARE(query.value(1).toDouble(), query.value(2).toDouble());
+			++groups;
+		}
+		QCOMPARE(groups, 3);
+
+		QVERIFY(query.exec("SELECT weighted_avg(value, weight) FROM readings WHERE sensor = 7"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toDouble(), 0.0);
+	}
+
+	void downsampling() {
+		TestDatabase db;
+		db.exec("CREATE TABLE series AS SELECT i AS x, CASE WHEN i = 50000 THEN 10 ELSE sin(i / 100.0) END AS y, "
+		        "TIMESTAMP '2024-01-01' + to_seconds(i) AS ts FROM range(100000) t(i)");
+		db.exec("INSERT INTO series VALUES (NULL, 1, NULL), (5, NULL, NULL)");
+
+		QSqlQuery query(db.db());
+		for (const char *function : {"lttb", "minmax_downsample"}) {
+			const QString points = QString("SELECT unnest(%1(x, y, 500)) AS p FROM series").arg(function);
+			QVERIFY2(query.exec("WITH s AS (" + points + ") SELECT count(*), min(p.x), max(p.x), max(p.y) FROM s"),
+			         qPrintable(query.lastError().text()));
+			QVERIFY(query.next());
+			QVERIFY(query.value(0).toLongLong() <= 1002);
+			QVERIFY(query.value(0).toLongLong() >= 500);
+			QCOMPARE(query.value(1).toLongLong(), qlonglong(0));
+			QCOMPARE(query.value(2).toLongLong(), qlonglong(99999));
+			// the spike is kept
+			QCOMPARE(query.value(3).toDouble(), 10.0);
+
+			// the points are ordered by x
+			QVERIFY(query.exec("WITH s AS (" + points + "), n AS (SELECT p.x, lag(p.x) OVER () AS previous FROM s) "
+			                   "SELECT count(*) FROM n WHERE x <= previous"));
+			QVERIFY(query.next());
+			QCOMPARE(query.value(0).toLongLong(), qlonglong(0));
+		}
+
+		QVERIFY(query.exec("WITH s AS (SELECT unnest(lttb(x, y, 500)) AS p FROM series) SELECT count(*) FROM s"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toLongLong(), qlonglong(500));
+
+		// per group and with timestamps
+		QVERIFY(query.exec("SELECT x % 2 AS half, len(lttb(ts, y, 100)) FROM series WHERE ts IS NOT NULL "
+		                   "GROUP BY half ORDER BY half"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(1).toLongLong(), qlonglong(100));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(1).toLongLong(), qlonglong(100));
+
+		QVERIFY(!query.exec("SELECT lttb(x, y, x) FROM series"));
+		QVERIFY(!query.exec("SELECT lttb(x, y, 1) FROM series"));
+	}
+
+	void invalidDefinition() {
+		TestDatabase db;
+		QDuckDBFunctionDefinition definition;
+		definition.name = "upper_name";
+		definition.argumentTypes = QStringList {"VARCHAR"};
+		definition.returnType = "VARCHAR";
+		definition.scalar = [](qsizetype, const void *const *, void *) {};
+		QVERIFY(!QDuckDBFunction::registerFunction(db.db(), definition));
+		QVERIFY(db.db().driver()->lastError().isValid());
+
+		definition.argumentTypes = QStringList {"DOUBLE"};
+		definition.returnType = "DOUBLE";
+		definition.scalar = nullptr;
+		QVERIFY(!QDuckDBFunction::registerFunction(db.db(), definition));
+	}
+};
@@ -1,9 +1,40 @@
 #pragma once
 
+#include "../../QtDuckDBDriver/QDuckDBAggregateTreeModel.h"
+#include "../../QtDuckDBDriver/QDuckDBRowCount.h"
+#include "../../QtDuckDBDriver/QDuckDBTableFunction.h"
+#include "../../QtDuckDBDriver/QDuckDBTableModel.h"
+#include "../../QtDuckDBDriver/QtDuckDBDriver.h"
 #include "../helpers/test_database.h"
 #include <QSqlQuery>
+#include <QSignalSpy>
+#include <QSqlQueryModel>
 #include <QSqlTableModel>
 #include <QTest>
+#include <QThread>
+#include <vector>
+
+// read-only model of orders which counts the values read per column
+class OrdersModel : public QAbstractTableModel {
+public:
+	int rowCount(const QModelIndex & = QModelIndex()) const override { return 3000; }
+	int columnCount(const QModelIndex & = QModelIndex()) const override { return 2; }
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override {
+		if (role != Qt::EditRole && role != Qt::DisplayRole)
+			return QVariant();
+		++reads[index.column()];
+		if (index.column() == 0)
+			return QStringLiteral("item%1").arg(index.row() % 3);
+		return index.row() + offset;
+	}
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override {
+		if (orientation == Qt::Horizontal && role == Qt::DisplayRole)
+			return section == 0 ? QStringLiteral("item") : QStringLiteral("amount");
+		return QAbstractTableModel::headerData(section, orientation, role);
+	}
+	mutable int reads[2] = {0, 0};
+	int offset = 0;
+};
 
 class ModelTest : public QObject {
 	Q_OBJECT
@@ -56,4 +87,361 @@ private slots:
 		QCOMPARE(model.rowCount(), 100);
 		QCOMPARE(model.data(model.index(50, 1)).toString(), "value_50");
 	}
+
+	void pagedModel() {
+		TestDatabase db;
+		db.exec("CREATE TABLE big_table AS SELECT (i * 7) % 10000 AS id, 'value_' || ((i * 7) % 10000) AS value "
+		        "FROM range(10000) t(i)");
+		db.exec("ALTER TABLE big_table ADD PRIMARY KEY (id)");
+
+		QDuckDBTableModel model(nullptr, db.db());
+		model.setPageSize(100);
+		model.setCachedPages(2);
+		QVERIFY2(model.setTable("big_table"), qPrintable(model.lastError().text()));
+		QCOMPARE(model.keyColumns(), QStringList({"id"}));
+		QCOMPARE(model.rowCount(), 10000);
+		QCOMPARE(model.columnCount(), 2);
+		QCOMPARE(model.headerData(1, Qt::Horizontal).toString(), "value");
+
+		// located with OFFSET, then the neighbours by their keys in both directions
+		for (int row : {5050, 5150, 5250, 4950, 4850, 9999, 0, 99, 100})
+			QCOMPARE(model.data(model.index(row, 1)).toString(), "value_" + QString::number(row));
+		QCOMPARE(model.data(model.index(10000, 1)), QVariant());
+		QVERIFY(!model.lastError().isValid());
+	}
+
+	void pagedModelCompositeKey() {
+		TestDatabase db;
+		db.exec("CREATE TABLE pairs AS SELECT i % 3 AS a, 'k' || lpad(i::VARCHAR, 4, '0') AS b, i AS v "
+		        "FROM range(1000) t(i)");
+
+		QDuckDBTableModel model(nullptr, db.db());
+		model.setPageSize(64);
+		QVERIFY(model.setTable("pairs", {"a", "b"}));
+		QCOMPARE(model.rowCount(), 1000);
+
+		// ordered by a, then b: 334 rows with a = 0 come first
+		QCOMPARE(model.data(model.index(333, 2)).toInt(), 999);
+		QCOMPARE(model.data(model.index(334, 2)).toInt(), 1);
+		QCOMPARE(model.data(model.index(398, 2)).toInt(), 193);
+		QCOMPARE(model.data(model.index(270, 2)).toInt(), 810);
+	}
+
+	void pagedModelSortAndFilter() {
+		TestDatabase db;
+		// 100 groups of 10 rows, every 10th group is NULL
+		db.exec("CREATE TABLE readings AS SELECT i AS id, CASE WHEN i % 100 < 10 THEN NULL ELSE i % 100 END AS grp, "
+		        "'sensor_' || (i % 7) AS name FROM range(1000) t(i)");
+		db.exec("ALTER TABLE readings ADD PRIMARY KEY (id)");
+
+		QDuckDBTableModel model(nullptr, db.db());
+		model.setPageSize(32);
+		QVERIFY(model.setTable("readings"));
+
+		model.sort(1, Qt::DescendingOrder);
+		QCOMPARE(model.rowCount(), 1000);
+		// 10 rows per group from 99 down to 10, then the NULLs ordered by id
+		QCOMPARE(model.data(model.index(0, 1)).toInt(), 99);
+		QCOMPARE(model.data(model.index(0, 0)).toInt(), 99);
+		QCOMPARE(model.data(model.index(9, 0)).toInt(), 999);
+		QCOMPARE(model.data(model.index(40, 1)).toInt(), 95);
+		QCOMPARE(model.data(model.index(899, 1)).toInt(), 10);
+		QVERIFY(model.data(model.index(900, 1)).isNull());
+		QCOMPARE(model.data(model.index(900, 0)).toInt(), 0);
+		QCOMPARE(model.data(model.index(999, 0)).toInt(), 909);
+		// walk back over the boundary of the NULLs
+		QCOMPARE(model.data(model.index(870, 1)).toInt(), 12);
+
+		QVERIFY(model.setFilter("grp < ?", {20}));
+		QCOMPARE(model.rowCount(), 100);
+		QCOMPARE(model.data(model.index(0, 1)).toInt(), 19);
+
+		QVERIFY(model.setFilterFixedString(2, "SENSOR_3"));
+		QCOMPARE(model.rowCount(), 14);
+		QVERIFY(model.setFilterFixedString(-1, ""));
+		QVERIFY(model.setFilter(QString()));
+		QCOMPARE(model.rowCount(), 1000);
+
+		model.sort(-1);
+		QCOMPARE(model.data(model.index(500, 0)).toInt(), 500);
+	}
+
+	void pagedModelRowid() {
+		TestDatabase db;
+		db.exec("CREATE TABLE no_key AS SELECT i AS v FROM range(500) t(i)");
+		db.exec("CREATE VIEW no_key_view AS SELECT v FROM no_key");
+
+		QDuckDBTableModel model(nullptr, db.db());
+		model.setPageSize(50);
+		QVERIFY(model.setTable("no_key"));
+		QCOMPARE(model.keyColumns(), QStringList({"rowid"}));
+		QCOMPARE(model.data(model.index(420, 0)).toInt(), 420);
+		QCOMPARE(model.data(model.index(470, 0)).toInt(), 470);
+
+		QVERIFY(model.setTable("no_key_view"));
+		QVERIFY(model.keyColumns().isEmpty());
+		QCOMPARE(model.rowCount(), 500);
+		QCOMPARE(model.data(model.index(123, 0)).toInt(), 123);
+	}
+	void pagedModelRefresh() {
+		TestDatabase db;
+		db.exec("CREATE TABLE live (id INTEGER PRIMARY KEY, value INTEGER)");
+		db.exec("INSERT INTO live SELECT i, i * 10 FROM range(100) t(i)");
+
+		QDuckDBTableModel model(nullptr, db.db());
+		model.setPageSize(10);
+		QVERIFY(model.setTable("live"));
+		QSignalSpy reset(&model, &QAbstractItemModel::modelReset);
+		QVERIFY(model.refresh());
+		QCOMPARE(reset.count(), 1);
+		for (int row = 0; row < model.rowCount(); ++row)
+			model.data(model.index(row, 1));
+
+		db.exec("UPDATE live SET value = -1 WHERE id IN (5, 6, 50)");
+		db.exec("DELETE FROM live WHERE id IN (10, 11, 12, 80)");
+		db.exec("INSERT INTO live VALUES (1000, 1), (1001, 2)");
+
+		QSignalSpy removed(&model, &QAbstractItemModel::rowsRemoved);
+		QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+		QSignalSpy changed(&model, &QAbstractItemModel::dataChanged);
+		QVERIFY(model.refresh());
+		QCOMPARE(reset.count(), 1);
+		QCOMPARE(removed.count(), 2);
+		QCOMPARE(removed.at(0).at(1).toInt(), 80);
+		QCOMPARE(removed.at(1).at(1).toInt(), 10);
+		QCOMPARE(removed.at(1).at(2).toInt(), 12);
+		QCOMPARE(inserted.count(), 1);
+		QCOMPARE(inserted.at(0).at(1).toInt(), 96);
+		QCOMPARE(inserted.at(0).at(2).toInt(), 97);
+		QCOMPARE(changed.count(), 2);
+		QCOMPARE(changed.at(0).at(0).toModelIndex().row(), 5);
+		QCOMPARE(changed.at(0).at(1).toModelIndex().row(), 6);
+		QCOMPARE(changed.at(1).at(0).toModelIndex().row(), 47);
+
+		QCOMPARE(model.rowCount(), 98);
+		QSqlQuery expected(db.db());
+		QVERIFY(expected.exec("SELECT id, value FROM live ORDER BY id"));
+		for (int row = 0; expected.next(); ++row) {
+			QCOMPARE(model.data(model.index(row, 0)), expected.value(0));
+			QCOMPARE(model.data(model.index(row, 1)), expected.value(1));
+		}
+
+		// a row which moves in the sort order is removed and inserted again
+		model.sort(1, Qt::AscendingOrder);
+		QVERIFY(model.refresh());
+		QCOMPARE(model.data(model.index(0, 0)).toInt(), 5);
+		db.exec("UPDATE live SET value = 5000 WHERE id = 5");
+		removed.clear();
+		inserted.clear();
+		QVERIFY(model.refresh());
+		QCOMPARE(removed.count(), 1);
+		QCOMPARE(removed.at(0).at(1).toInt(), 0);
+		QCOMPARE(inserted.count(), 1);
+		QCOMPARE(inserted.at(0).at(1).toInt(), 97);
+		QCOMPARE(model.data(model.index(97, 0)).toInt(), 5);
+		QCOMPARE(model.data(model.index(0, 0)).toInt(), 6);
+	}
+
+	void pagedModelRefreshKeepsMetadataCache() {
+		{
+			QSqlDatabase db = QSqlDatabase::addDatabase("DUCKDB", "refresh_cache_1");
+			db.setDatabaseName(":memory:refresh_cache");
+			db.setConnectOptions("SHARED_INSTANCE");
+			QVERIFY(db.open());
+			QSqlDatabase other = QSqlDatabase::cloneDatabase(db, "refresh_cache_2");
+			QVERIFY(other.open());
+			QVERIFY(QSqlQuery(db).exec("CREATE TABLE live (id INTEGER PRIMARY KEY, value INTEGER)"));
+			QVERIFY(QSqlQuery(db).exec("CREATE TABLE other (id INTEGER)"));
+
+			QDuckDBTableModel model(nullptr, db);
+			QVERIFY(model.setTable("live"));
+			QVERIFY(model.refresh());
+			QCOMPARE(db.record("other").count(), 1);
+
+			// the cache is not dropped by the refreshes, so it misses the change of the other connection
+			QVERIFY(QSqlQuery(other).exec("ALTER TABLE other ADD COLUMN name VARCHAR"));
+			QVERIFY(QSqlQuery(db).exec("INSERT INTO live VALUES (1, 10)"));
+			QVERIFY(model.refresh());
+			QVERIFY(model.refresh());
+			QCOMPARE(model.rowCount(), 1);
+			QCOMPARE(db.record("other").count(), 1);
+		}
+		QSqlDatabase::removeDatabase("refresh_cache_1");
+		QSqlDatabase::removeDatabase("refresh_cache_2");
+	}
+
+	void aggregateTree() {
+		TestDatabase db;
+		db.exec("CREATE TABLE readings AS SELECT ['north', 'south'][i % 2 + 1] AS region, 'site' || (i % 4) AS site, "
+		        "'device' || (i % 8) AS device, i AS value FROM range(800) t(i)");
+
+		QDuckDBAggregateTreeModel model(nullptr, db.db());
+		QVERIFY(model.setQuery("readings", {"region", "site", "device"}, {"count(*)", "sum(value)"}));
+		QCOMPARE(model.columnCount(), 3);
+		QCOMPARE(model.rowCount(), 2);
+		const QModelIndex north = model.index(0, 0);
+		const QModelIndex south = model.index(1, 0);
+		QCOMPARE(model.data(north).toString(), QString("north"));
+		QCOMPARE(model.data(model.index(0, 1)).toLongLong(), qlonglong(400));
+		QVERIFY(model.hasChildren(north));
+		QCOMPARE(model.rowCount(north), 0);
+
+		// expanding one region groups the sites of both regions with one query
+		QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+		QVERIFY(model.canFetchMore(north));
+		model.fetchMore(north);
+		QCOMPARE(inserted.count(), 2);
+		QVERIFY(!model.canFetchMore(north));
+		QVERIFY(!model.canFetchMore(south));
+		QCOMPARE(model.rowCount(north), 2);
+		QCOMPARE(model.rowCount(south), 2);
+		const QModelIndex site1 = model.index(1, 0, south);
+		QCOMPARE(model.data(site1).toString(), QString("site3"));
+		QCOMPARE(model.data(model.index(1, 1, south)).toLongLong(), qlonglong(200));
+		QCOMPARE(model.parent(site1), south);
+		QCOMPARE(model.groupPath(site1), QVariantList({"south", "site3"}));
+
+		model.fetchMore(site1);
+		QCOMPARE(model.rowCount(site1), 2);
+		QCOMPARE(model.data(model.index(0, 0, site1)).toString(), QString("device3"));
+		QCOMPARE(model.data(model.index(0, 1, site1)).toLongLong(), qlonglong(100));
+		QVERIFY(!model.hasChildren(model.index(0, 0, site1)));
+		QVERIFY(!model.canFetchMore(model.index(0, 0, site1)));
+
+		QVERIFY(model.setFilter("value < ?", {400}));
+		QCOMPARE(model.data(model.index(0, 1)).toLongLong(), qlonglong(200));
+		QVERIFY(model.canFetchMore(model.index(0, 0)));
+	}
+
+	void modelAsTableFunction() {
+		TestDatabase db;
+		db.exec("CREATE TABLE prices (item VARCHAR, price DOUBLE)");
+		db.exec("INSERT INTO prices VALUES ('item0', 1.5), ('item1', 2), ('item2', 0.5)");
+
+		OrdersModel orders;
+		QVERIFY(QDuckDBTableFunction::registerModel(db.db(), "orders", &orders));
+		QSqlQuery query(db.db());
+		QVERIFY(query.exec("SELECT o.item, sum(o.amount * p.price) FROM orders o JOIN prices p USING (item) "
+		                   "GROUP BY o.item ORDER BY o.item"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toString(), QString("item0"));
+		QCOMPARE(query.value(1).toDouble(), 1.5 * 3 * (999 * 1000 / 2));
+
+		// only the referenced columns are copied, apart from the first row which gives the column types
+		orders.reads[0] = orders.reads[1] = 0;
+		QVERIFY(query.exec("SELECT sum(amount) FROM orders"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toLongLong(), qlonglong(2999 * 3000 / 2));
+		QVERIFY(orders.reads[1] >= 3000);
+		QVERIFY(orders.reads[0] <= 1);
+
+		// each execution copies the model again, also of a statement prepared once
+		QVERIFY(query.prepare("SELECT sum(amount) FROM orders"));
+		QVERIFY(query.exec());
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toLongLong(), qlonglong(2999 * 3000 / 2));
+		orders.offset = 1;
+		QVERIFY(query.exec());
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toLongLong(), qlonglong(2999 * 3000 / 2 + 3000));
+		orders.offset = 0;
+
+		// models of other threads are not read
+		QThread thread;
+		auto *foreign = new OrdersModel();
+		foreign->moveToThread(&thread);
+		QVERIFY(QDuckDBTableFunction::registerModel(db.db(), "foreign_orders", foreign));
+		QVERIFY(!query.exec("SELECT sum(amount) FROM foreign_orders"));
+		QCOMPARE(foreign->reads[0] + foreign->reads[1], 0);
+		QVERIFY(QDuckDBTableFunction::unregister(db.db(), "foreign_orders"));
+		delete foreign;
+
+		QVERIFY(QDuckDBTableFunction::unregister(db.db(), "orders"));
+		QVERIFY(!query.exec("SELECT * FROM orders"));
+		QVERIFY(!QDuckDBTableFunction::unregister(db.db(), "orders"));
+	}
+
+	void columnsAsTableFunction() {
+		struct Sample {
+			qint64 time;
+			double value;
+			qint32 flag;
+		};
+		std::vector<Sample> samples;
+		std::vector<double> weights;
+		for (int i = 0; i < 5000; ++i) {
+			samples.push_back({i, i * 0.5, i % 2});
+			weights.push_back(2.0);
+		}
+
+		TestDatabase db;
+		QDuckDBTableFunction::Columns columns(static_cast<qsizetype>(samples.size()));
+		columns.add("time", &samples[0].time, sizeof(Sample))
+		    .add("value", &samples[0].value, sizeof(Sample))
+		    .add("flag", &samples[0].flag, sizeof(Sample))
+		    .add("weight", weights.data());
+		QVERIFY(QDuckDBTableFunction::registerColumns(db.db(), "samples", columns));
+
+		QSqlQuery query(db.db());
+		QVERIFY(query.exec("SELECT count(*), max(time), sum(value * weight) FROM samples WHERE flag = 1"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toLongLong(), qlonglong(2500));
+		QCOMPARE(query.value(1).toLongLong(), qlonglong(4999));
+		QCOMPARE(query.value(2).toDouble(), 2500.0 * 2500.0);
+
+		QVERIFY(query.exec("SELECT typeof(time), typeof(flag), typeof(weight) FROM samples LIMIT 1"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toString(), QString("BIGINT"));
+		QCOMPARE(query.value(1).toString(), QString("INTEGER"));
+		QCOMPARE(query.value(2).toString(), QString("DOUBLE"));
+	}
+
+	void estimatedRowCount() {
+		TestDatabase db;
+		db.exec("CREATE TABLE counted AS SELECT i AS id, i % 10 AS digit FROM range(10000) t(i)");
+
+		QCOMPARE(QDuckDBRowCount::estimate(db.db(), "SELECT * FROM counted"), qlonglong(10000));
+		QVERIFY(QDuckDBRowCount::estimate(db.db(), "SELECT * FROM counted WHERE digit = ?", {3}) >= 0);
+		QCOMPARE(QDuckDBRowCount::estimate(db.db(), "SELECT * FROM missing_table"), qlonglong(-1));
+
+		QSqlQuery query(db.db());
+		QVERIFY(query.prepare("SELECT * FROM counted WHERE id < ?"));
+		query.addBindValue(5000);
+		QVERIFY(QDuckDBRowCount::estimate(query) >= 0);
+		QVERIFY(query.exec());
+		QVERIFY(query.next());
+
+		// the estimate of the result of a QSqlQueryModel, without planning its query again
+		QSqlQueryModel model;
+		model.setQuery("SELECT * FROM counted", db.db());
+		QCOMPARE(QDuckDBRowCount::estimate(model.query()), qlonglong(10000));
+		QCOMPARE(model.query().result()->handle().value<DuckDBResultHandle>().estimatedRows, qlonglong(10000));
+	}
+
+	void pagedModelEstimatedRowCount() {
+		TestDatabase db;
+		db.exec("CREATE TABLE counted (id INTEGER PRIMARY KEY, digit INTEGER)");
+		db.exec("INSERT INTO counted SELECT i, i % 10 FROM range(10000) t(i)");
+
+		QDuckDBTableModel model(nullptr, db.db());
+		model.setEstimatedRowCount(true);
+		QVERIFY(model.setTable("counted"));
+		QCOMPARE(model.rowCount(), 10000);
+
+		// the estimate of a filter differs from its exact count, which replaces it from the event loop
+		model.setFilter("digit = ?", {3});
+		QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+		QSignalSpy removed(&model, &QAbstractItemModel::rowsRemoved);
+		QTRY_COMPARE(model.rowCount(), 1000);
+		QCOMPARE(model.data(model.index(999, 0)).toInt(), 9993);
+		QVERIFY(inserted.count() + removed.count() <= 1);
+
+		// a count of an outdated selection is discarded
+		model.setFilter("digit < ?", {5});
+		model.setFilter("digit = ?", {7});
+		QTRY_COMPARE(model.rowCount(), 1000);
+		QTest::qWait(10);
+		QCOMPARE(model.rowCount(), 1000);
+		QCOMPARE(model.data(model.index(0, 0)).toInt(), 7);
+	}
 };
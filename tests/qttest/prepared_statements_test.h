@@ -94,4 +94,115 @@ private slots:
 		QCOMPARE(retrieved.second(), t.second());
 	}
 
+	void prepareManyStatementsWithOneQuery() {
+		TestDatabase db;
+		db.exec("CREATE TABLE items (id INTEGER, name VARCHAR)");
+
+		QSqlQuery q(db.db());
+		for (int i = 0; i < 100; ++i) {
+			QVERIFY(q.prepare("INSERT INTO items VALUES (?, ?)"));
+			q.addBindValue(i);
+			q.addBindValue(QString::number(i));
+			QVERIFY(q.exec());
+			QCOMPARE(q.numRowsAffected(), 1);
+
+			QVERIFY(q.prepare("SELECT count(*), max(id) FROM items WHERE name = ?"));
+			q.addBindValue(QString::number(i));
+			QVERIFY(q.exec());
+			QCOMPARE(q.record().count(), 2);
+			QVERIFY(q.next());
+			QCOMPARE(q.value(0).toInt(), 1);
+			QCOMPARE(q.value(1).toInt(), i);
+		}
+
+		QVERIFY(!q.prepare("SELECT * FROM no_such_table"));
+		QVERIFY(!q.exec());
+		QCOMPARE(q.numRowsAffected(), -1);
+	}
+
+	void execSameStatementAgain() {
+		TestDatabase db;
+		db.exec("CREATE TABLE items (id INTEGER)");
+
+		// exec(sql) prepares the same statement again, which keeps DuckDB's prepared statement
+		QSqlQuery q(db.db());
+		for (int i = 0; i < 50; ++i) {
+			QVERIFY(q.exec("INSERT INTO items VALUES (" + QString::number(i) + ")"));
+			QVERIFY(q.exec("SELECT count(*) FROM items"));
+			QVERIFY(q.next());
+			QCOMPARE(q.value(0).toInt(), i + 1);
+		}
+
+		// a schema change prepares the statement again
+		QVERIFY(q.exec("SELECT * FROM items"));
+		QCOMPARE(q.record().count(), 1);
+		db.exec("ALTER TABLE items ADD COLUMN name VARCHAR DEFAULT 'x'");
+		QVERIFY2(q.exec("SELECT * FROM items"), qPrintable(q.lastError().text()));
+		QCOMPARE(q.record().count(), 2);
+		QVERIFY(q.next());
+		QCOMPARE(q.value(1).toString(), QString("x"));
+
+		db.exec("DROP TABLE items");
+		QVERIFY(!q.exec("SELECT * FROM items"));
+		db.exec("CREATE TABLE items (id VARCHAR)");
+		db.exec("INSERT INTO items VALUES ('first')");
+		QVERIFY2(q.exec("SELECT * FROM items"), qPrintable(q.lastError().text()));
+		QCOMPARE(q.record().count(), 1);
+		QCOMPARE(q.record().field(0).value().userType(), static_cast<int>(QMetaType::QString));
+		QVERIFY(q.next());
+		QCOMPARE(q.value(0).toString(), QString("first"));
+	}
+
+	void execSameStatementAfterChangeOfOtherConnection() {
+		{
+			QSqlDatabase first = QSqlDatabase::addDatabase("DUCKDB", "reprepare_1");
+			first.setDatabaseName(":memory:reprepare");
+			first.setConnectOptions("SHARED_INSTANCE");
+			QVERIFY(first.open());
+			QSqlDatabase second = QSqlDatabase::cloneDatabase(first, "reprepare_2");
+			QVERIFY(second.open());
+
+			QVERIFY(QSqlQuery(first).exec("CREATE TABLE items (id INTEGER)"));
+			QVERIFY(QSqlQuery(first).exec("INSERT INTO items VALUES (1)"));
+			QSqlQuery q(second);
+			QVERIFY(q.exec("SELECT * FROM items"));
+			QCOMPARE(q.record().count(), 1);
+
+			// not seen by the driver of second, the kept statement no longer binds to the same types
+			QVERIFY(QSqlQuery(first).exec("DROP TABLE items"));
+			QVERIFY(QSqlQuery(first).exec("CREATE TABLE items (id VARCHAR, name VARCHAR)"));
+			QVERIFY(QSqlQuery(first).exec("INSERT INTO items VALUES ('a', 'b')"));
+			QVERIFY2(q.exec("SELECT * FROM items"), qPrintable(q.lastError().text()));
+			QCOMPARE(q.record().count(), 2);
+			QVERIFY(q.next());
+			QCOMPARE(q.value(1).toString(), QString("b"));
+		}
+		QSqlDatabase::removeDatabase("reprepare_1");
+		QSqlDatabase::removeDatabase("reprepare_2");
+	}
+
+	void recordAfterRebind() {
+		TestDatabase db;
+		QSqlQuery q(db.db());
+		QVERIFY(q.prepare("SELECT ? AS v"));
+
+		// a parameter of another type makes DuckDB rebind the statement with other result types
+		q.bindValue(0, 42);
+		QVERIFY(q.exec());
+		QVERIFY(q.next());
+		QCOMPARE(q.value(0).userType(), static_cast<int>(QMetaType::LongLong));
+		QCOMPARE(q.value(0).toLongLong(), 42);
+
+		q.bindValue(0, QByteArray("blob"));
+		QVERIFY2(q.exec(), qPrintable(q.lastError().text()));
+		QVERIFY(q.next());
+		QCOMPARE(q.value(0).userType(), static_cast<int>(QMetaType::QByteArray));
+		QCOMPARE(q.value(0).toByteArray(), QByteArray("blob"));
+
+		q.bindValue(0, 7);
+		QVERIFY(q.exec());
+		QCOMPARE(q.record().count(), 1);
+		QVERIFY(q.next());
+		QCOMPARE(q.value(0).toLongLong(), 7);
+	}
 };
@@ -0,0 +1,2 @@
+#include "progress_test.h"
+#include "moc_progress_test.cpp"
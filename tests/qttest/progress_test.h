@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../helpers/test_database.h"
+#include <QSignalSpy>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTest>
+
+class ProgressTest : public QObject {
+	Q_OBJECT
+
+private slots:
+	void progressReported() {
+		{
+			QSqlDatabase db = QSqlDatabase::addDatabase("DUCKDB", "progress_reported");
+			db.setConnectOptions("PROGRESS_INTERVAL_MS=1");
+			QVERIFY2(db.open(), qPrintable(db.lastError().text()));
+
+			QSignalSpy spy(db.driver(), SIGNAL(queryProgress(double, qulonglong, qulonglong)));
+			QVERIFY(spy.isValid());
+
+			QSqlQuery q(db);
+			QVERIFY(q.exec("CREATE TABLE t AS SELECT range AS x FROM range(30000)"));
+			QVERIFY(q.exec("SELECT SUM(a.x * b.x) FROM t a, t b"));
+			QVERIFY(q.next());
+
+			QVERIFY(spy.count() > 0);
+			for (const auto &arguments : spy) {
+				const double percentage = arguments.at(0).toDouble();
+				QVERIFY(percentage >= 0.0 && percentage <= 100.0);
+			}
+		}
+		QSqlDatabase::removeDatabase("progress_reported");
+	}
+
+	void noProgressByDefault() {
+		TestDatabase db;
+		QSignalSpy spy(db.db().driver(), SIGNAL(queryProgress(double, qulonglong, qulonglong)));
+		QVERIFY(spy.isValid());
+
+		auto q = db.exec("SELECT SUM(range) FROM range(10000000)");
+		db.checkNoError(q);
+		QVERIFY(q.next());
+		QCOMPARE(spy.count(), 0);
+	}
+};
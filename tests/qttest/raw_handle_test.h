@@ -3,6 +3,8 @@
 #include "../../QtDuckDBDriver/QtDuckDBDriver.h"
 #include "../helpers/test_database.h"
 #include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlResult>
 #include <QTest>
 #include <duckdb.hpp>
 
@@ -50,4 +52,35 @@ private slots:
 		QVERIFY(query.next());
 		QCOMPARE(query.value(0).toInt(), 1);
 	}
+
+	void resultHandle() {
+		TestDatabase db;
+		QSqlQuery query(db.db());
+		query.setForwardOnly(true);
+		QVERIFY(query.exec("SELECT i FROM range(5000) t(i)"));
+		auto handle = query.result()->handle().value<DuckDBResultHandle>();
+		QVERIFY(handle.prepared);
+		QVERIFY(handle.result);
+
+		// reads every chunk in place and skips the rows read
+		qint64 sum = 0;
+		int rows = 0;
+		while (query.next()) {
+			handle = query.result()->handle().value<DuckDBResultHandle>();
+			QVERIFY(handle.chunk);
+			QCOMPARE(query.value(0).toLongLong(), qlonglong(handle.chunk->GetValue(0, handle.row).GetValue<int64_t>()));
+			duckdb::UnifiedVectorFormat column;
+			handle.chunk->data[0].ToUnifiedFormat(handle.chunk->size(), column);
+			const auto values = duckdb::UnifiedVectorFormat::GetData<int64_t>(column);
+			for (duckdb::idx_t i = handle.row; i < handle.chunk->size(); ++i)
+				sum += values[column.sel->get_index(i)];
+			const int remaining = static_cast<int>(handle.chunk->size() - handle.row);
+			rows += remaining;
+			if (remaining > 1)
+				QVERIFY(query.seek(remaining - 1, true));
+		}
+		QCOMPARE(rows, 5000);
+		QCOMPARE(sum, qint64(4999 * 5000 / 2));
+		QVERIFY(!query.result()->handle().value<DuckDBResultHandle>().chunk);
+	}
 };
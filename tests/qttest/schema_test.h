@@ -1,10 +1,14 @@
 #pragma once
 
 #include "../helpers/test_database.h"
+#include <QDateTime>
+#include <QMetaObject>
 #include <QSqlDriver>
 #include <QSqlIndex>
+#include <QSqlQuery>
 #include <QSqlRecord>
 #include <QTest>
+#include <QUuid>
 
 class SchemaTest : public QObject {
 	Q_OBJECT
@@ -70,6 +74,159 @@ private slots:
 		QVERIFY(rec.contains("name"));
 	}
 
+	void recordQualifiedName() {
+		TestDatabase db;
+		db.exec("CREATE SCHEMA sales");
+		db.exec("CREATE TABLE items (id INTEGER)");
+		db.exec("CREATE TABLE sales.items (id INTEGER, amount DECIMAL(18, 3), \"odd.name\" VARCHAR)");
+
+		QCOMPARE(db.db().record("items").count(), 1);
+		QCOMPARE(db.db().record("sales.items").count(), 3);
+		QCOMPARE(db.db().record("\"sales\".\"items\"").count(), 3);
+		QCOMPARE(db.db().record("memory.sales.items").count(), 3);
+
+		const QSqlRecord rec = db.db().record("sales.items");
+		QVERIFY(rec.contains("odd.name"));
+		QCOMPARE(rec.field("amount").length(), 18);
+		QCOMPARE(rec.field("amount").precision(), 3);
+	}
+
+	void recordFieldTypes() {
+		TestDatabase db;
+		db.exec("SET TimeZone = 'Europe/Berlin'");
+		db.exec("CREATE TABLE typed (stamp TIMESTAMPTZ, id UUID, big HUGEINT, amount DECIMAL(38, 10))");
+		db.exec("INSERT INTO typed VALUES ('2024-03-01 12:30:00.250+00', 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11', "
+		        "170141183460469231731687303715884105727, 12345678901234567890.0123456789)");
+
+		const QSqlRecord rec = db.db().record("typed");
+		QCOMPARE(rec.field("stamp").value().userType(), int(QMetaType::QDateTime));
+		QCOMPARE(rec.field("id").value().userType(), int(QMetaType::QUuid));
+		QCOMPARE(rec.field("big").value().userType(), int(QMetaType::QString));
+		QCOMPARE(rec.field("amount").value().userType(), int(QMetaType::Double));
+
+		// the values have the types of the fields
+		QSqlQuery query(db.db());
+		QVERIFY(query.exec("SELECT stamp, id, big FROM typed"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toDateTime(), QDateTime::fromString("2024-03-01T12:30:00.250Z", Qt::ISODateWithMs));
+		QCOMPARE(query.value(0).toDateTime().offsetFromUtc(), 0);
+		QCOMPARE(query.value(1).toUuid(), QUuid("a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11"));
+		QCOMPARE(query.value(2).toString(), QString("170141183460469231731687303715884105727"));
+
+		// QDateTime has milliseconds, infinite values are fetched as text
+		QVERIFY(query.exec("SELECT TIMESTAMPTZ '1969-12-31 23:59:59.9995+00', TIMESTAMPTZ 'infinity', "
+		                   "TIMESTAMPTZ '-infinity'"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toDateTime(), QDateTime::fromString("1969-12-31T23:59:59.999Z", Qt::ISODateWithMs));
+		QCOMPARE(query.value(1).toString(), QString("infinity"));
+		QCOMPARE(query.value(2).toString(), QString("-infinity"));
+
+		// DECIMAL is exact with QSql::HighPrecision, like numeric columns of the other Qt drivers
+		query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+		QVERIFY(query.exec("SELECT amount FROM typed"));
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toString(), QString("12345678901234567890.0123456789"));
+
+		// UUIDs are bound without braces
+		QVERIFY(query.prepare("SELECT count(*) FROM typed WHERE id = ?"));
+		query.addBindValue(QUuid("a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11"));
+		QVERIFY(query.exec());
+		QVERIFY(query.next());
+		QCOMPARE(query.value(0).toLongLong(), qlonglong(1));
+	}
+
+	void recordTemporaryTableShadows() {
+		TestDatabase db;
+		db.exec("CREATE TABLE items (id INTEGER)");
+		db.exec("CREATE TEMP TABLE items (id INTEGER, name VARCHAR)");
+		QCOMPARE(db.db().record("items").count(), 2);
+	}
+
+	void primaryIndexComposite() {
+		TestDatabase db;
+		db.exec("CREATE SEQUENCE seq_id START 1");
+		db.exec("CREATE TABLE pairs (a INTEGER DEFAULT nextval('seq_id'), b VARCHAR, c INTEGER, PRIMARY KEY (c, a))");
+
+		const QSqlIndex index = db.db().primaryIndex("pairs");
+		QCOMPARE(index.count(), 2);
+		QCOMPARE(index.fieldName(0), "c");
+		QCOMPARE(index.fieldName(1), "a");
+		QVERIFY(index.field(1).isAutoValue());
+		QVERIFY(!index.field(0).isAutoValue());
+	}
+
+	void prefetchMetadata() {
+		TestDatabase db;
+		db.exec("CREATE TABLE first (id INTEGER PRIMARY KEY)");
+		db.exec("CREATE TABLE second (id INTEGER, name VARCHAR)");
+
+		bool ok = false;
+		QVERIFY(QMetaObject::invokeMethod(db.db().driver(), "prefetchMetadata", Q_RETURN_ARG(bool, ok),
+		                                  Q_ARG(QStringList, QStringList({"first", "second", "missing"}))));
+		QVERIFY(ok);
+		QCOMPARE(db.db().record("first").count(), 1);
+		QCOMPARE(db.db().primaryIndex("first").count(), 1);
+		QCOMPARE(db.db().record("second").count(), 2);
+		QCOMPARE(db.db().primaryIndex("second").count(), 0);
+		QCOMPARE(db.db().record("missing").count(), 0);
+	}
+
+	void metadataCacheInvalidatedByDdl() {
+		TestDatabase db;
+		db.exec("CREATE TABLE cached (id INTEGER PRIMARY KEY)");
+		QCOMPARE(db.db().record("cached").count(), 1);
+		QCOMPARE(db.db().tables().size(), 1);
+
+		db.exec("ALTER TABLE cached ADD COLUMN name VARCHAR");
+		QCOMPARE(db.db().record("cached").count(), 2);
+
+		db.exec("CREATE TABLE cached2 (id INTEGER)");
+		QCOMPARE(db.db().tables().size(), 2);
+	}
+
+	void metadataCacheInvalidatedByRollback() {
+		TestDatabase db;
+		db.exec("CREATE TABLE cached (id INTEGER)");
+		QVERIFY(db.db().transaction());
+		db.exec("ALTER TABLE cached ADD COLUMN name VARCHAR");
+		QCOMPARE(db.db().record("cached").count(), 2);
+		QVERIFY(db.db().rollback());
+		QCOMPARE(db.db().record("cached").count(), 1);
+
+		// detected from the parsed statement, not from the text
+		db.exec("BEGIN TRANSACTION");
+		db.exec("ALTER TABLE cached ADD COLUMN name VARCHAR");
+		QCOMPARE(db.db().record("cached").count(), 2);
+		db.exec("/* undo */ ABORT");
+		QCOMPARE(db.db().record("cached").count(), 1);
+	}
+
+	void metadataCacheExplicitInvalidation() {
+		const QString path = ":memory:metadata_cache";
+		{
+			QSqlDatabase first = QSqlDatabase::addDatabase("DUCKDB", "metadata_cache_1");
+			first.setDatabaseName(path);
+			first.setConnectOptions("SHARED_INSTANCE");
+			QVERIFY(first.open());
+			QSqlDatabase second = QSqlDatabase::addDatabase("DUCKDB", "metadata_cache_2");
+			second.setDatabaseName(path);
+			second.setConnectOptions("SHARED_INSTANCE");
+			QVERIFY(second.open());
+
+			QVERIFY(QSqlQuery(first).exec("CREATE TABLE cached (id INTEGER)"));
+			QCOMPARE(second.record("cached").count(), 1);
+
+			// schema changes of other connections are not detected
+			QVERIFY(QSqlQuery(first).exec("ALTER TABLE cached ADD COLUMN name VARCHAR"));
+			QCOMPARE(second.record("cached").count(), 1);
+
+			QVERIFY(QMetaObject::invokeMethod(second.driver(), "invalidateMetadataCache"));
+			QCOMPARE(second.record("cached").count(), 2);
+		}
+		QSqlDatabase::removeDatabase("metadata_cache_1");
+		QSqlDatabase::removeDatabase("metadata_cache_2");
+	}
+
 	void escapeIdentifierEmpty() {
 		TestDatabase db;
 		auto escaped = db.db().driver()->escapeIdentifier("", QSqlDriver::FieldName);
@@ -0,0 +1,2 @@
+#include "shared_instance_test.h"
+#include "moc_shared_instance_test.cpp"
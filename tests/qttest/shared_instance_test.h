@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../../QtDuckDBDriver/QtDuckDBDriver.h"
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTest>
+#include <QThread>
+#include <atomic>
+
+class SharedInstanceTest : public QObject {
+	Q_OBJECT
+
+private slots:
+	void connectionsShareInstance() {
+		{
+			QSqlDatabase db1 = QSqlDatabase::addDatabase("DUCKDB", "shared_1");
+			db1.setDatabaseName(":memory:shared_instance_test");
+			db1.setConnectOptions("SHARED_INSTANCE");
+			QVERIFY2(db1.open(), qPrintable(db1.lastError().text()));
+
+			QSqlDatabase db2 = QSqlDatabase::cloneDatabase(db1, "shared_2");
+			QVERIFY2(db2.open(), qPrintable(db2.lastError().text()));
+
+			auto h1 = db1.driver()->handle().value<DuckDBConnectionHandle>();
+			auto h2 = db2.driver()->handle().value<DuckDBConnectionHandle>();
+			QCOMPARE(h1.db, h2.db);
+			QVERIFY(h1.connection != h2.connection);
+
+			QSqlQuery q1(db1);
+			QVERIFY(q1.exec("CREATE TABLE items (id INTEGER)"));
+			QVERIFY(q1.exec("INSERT INTO items VALUES (1), (2), (3)"));
+
+			QSqlQuery q2(db2);
+			QVERIFY(q2.exec("SELECT COUNT(*) FROM items"));
+			QVERIFY(q2.next());
+			QCOMPARE(q2.value(0).toInt(), 3);
+		}
+		QSqlDatabase::removeDatabase("shared_2");
+		QSqlDatabase::removeDatabase("shared_1");
+	}
+
+	void cloneInWorkerThread() {
+		{
+			QSqlDatabase db = QSqlDatabase::addDatabase("DUCKDB", "shared_main");
+			db.setDatabaseName(":memory:shared_worker_test");
+			db.setConnectOptions("SHARED_INSTANCE");
+			QVERIFY2(db.open(), qPrintable(db.lastError().text()));
+			QSqlQuery q(db);
+			QVERIFY(q.exec("CREATE TABLE items AS SELECT range AS id FROM range(1000)"));
+
+			std::atomic<int> count {-1};
+			QThread *worker = QThread::create([&count]() {
+				{
+					QSqlDatabase clone = QSqlDatabase::cloneDatabase("shared_main", "shared_worker");
+					if (!clone.open())
+						return;
+					QSqlQuery wq(clone);
+					if (wq.exec("SELECT COUNT(*) FROM items") && wq.next())
+						count = wq.value(0).toInt();
+				}
+				QSqlDatabase::removeDatabase("shared_worker");
+			});
+			worker->start();
+			QVERIFY(worker->wait(30000));
+			delete worker;
+			QCOMPARE(count.load(), 1000);
+		}
+		QSqlDatabase::removeDatabase("shared_main");
+	}
+
+	void separateInstancesWithoutOption() {
+		{
+			QSqlDatabase db1 = QSqlDatabase::addDatabase("DUCKDB", "unshared_1");
+			db1.setDatabaseName(":memory:unshared_test");
+			QVERIFY2(db1.open(), qPrintable(db1.lastError().text()));
+			QSqlDatabase db2 = QSqlDatabase::cloneDatabase(db1, "unshared_2");
+			QVERIFY2(db2.open(), qPrintable(db2.lastError().text()));
+
+			auto h1 = db1.driver()->handle().value<DuckDBConnectionHandle>();
+			auto h2 = db2.driver()->handle().value<DuckDBConnectionHandle>();
+			QVERIFY(h1.db != h2.db);
+		}
+		QSqlDatabase::removeDatabase("unshared_2");
+		QSqlDatabase::removeDatabase("unshared_1");
+	}
+};
@@ -0,0 +1,2 @@
+#include "typed_query_test.h"
+#include "moc_typed_query_test.cpp"
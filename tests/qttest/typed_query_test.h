@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../../QtDuckDBDriver/QDuckDBTypedQuery.h"
+#include "../helpers/test_database.h"
+#include <QTest>
+
+class TypedQueryTest : public QObject {
+	Q_OBJECT
+
+private slots:
+	void tuples() {
+		TestDatabase db;
+		QDuckDBTypedQuery<qint64, QString, double, std::optional<int>, bool> query(db.db());
+		QVERIFY2(query.exec("SELECT i, 'row' || i, i * 0.5, CASE WHEN i % 10 = 0 THEN NULL ELSE i::INTEGER END, "
+		                    "i % 2 = 0 FROM range(3000) t(i) ORDER BY i"),
+		         qPrintable(query.lastError().text()));
+		QCOMPARE(query.rows().size(), size_t(3000));
+
+		const auto &[id, label, half, sparse, even] = query.rows()[2101];
+		QCOMPARE(id, qint64(2101));
+		QCOMPARE(label, QString("row2101"));
+		QCOMPARE(half, 1050.5);
+		QCOMPARE(sparse, std::optional<int>(2101));
+		QCOMPARE(even, false);
+		QCOMPARE(std::get<3>(query.rows()[2100]), std::optional<int>());
+	}
+
+	void structs() {
+		struct Item {
+			qint64 id;
+			QString name;
+			double price;
+		};
+		TestDatabase db;
+		db.exec("CREATE TABLE items (id BIGINT, name VARCHAR, price DECIMAL(10, 2))");
+		db.exec("INSERT INTO items VALUES (1, 'lamp', 19.99), (2, 'desk', 149.5), (3, 'chair', 89)");
+
+		QDuckDBTypedQuery<qint64, QString, double> query(db.db());
+		QVERIFY2(query.exec("SELECT id, name, price FROM items WHERE price > ? AND name <> ? ORDER BY id", 50,
+		                    QString("desk")),
+		         qPrintable(query.lastError().text()));
+		const std::vector<Item> items = query.as<Item>();
+		QCOMPARE(items.size(), size_t(1));
+		QCOMPARE(items[0].id, qint64(3));
+		QCOMPARE(items[0].name, QString("chair"));
+		QCOMPARE(items[0].price, 89.0);
+	}
+
+	void parameters() {
+		TestDatabase db;
+		QDuckDBTypedQuery<std::optional<qint64>, std::optional<QString>> query(db.db());
+		QVERIFY(query.exec("SELECT ?::BIGINT, ?::VARCHAR", std::optional<qint64>(), std::optional<QString>("set")));
+		QCOMPARE(query.rows().size(), size_t(1));
+		QCOMPARE(std::get<0>(query.rows()[0]), std::optional<qint64>());
+		QCOMPARE(std::get<1>(query.rows()[0]), std::optional<QString>("set"));
+
+		QVERIFY(query.exec("SELECT ?::BIGINT + 1, 'x' WHERE ?", quint8(41), true));
+		QCOMPARE(std::get<0>(query.rows()[0]), std::optional<qint64>(42));
+		QVERIFY(query.exec("SELECT ?::BIGINT, 'x' WHERE ?", 1, false));
+		QVERIFY(query.rows().empty());
+	}
+
+	void schemaMismatch() {
+		TestDatabase db;
+		QDuckDBTypedQuery<qint64, QString> query(db.db());
+		QVERIFY(!query.exec("SELECT 1"));
+		QVERIFY(query.lastError().isValid());
+		QVERIFY(query.rows().empty());
+
+		QVERIFY(!query.exec("SELECT 'text' AS first, 'text' AS second"));
+		QVERIFY(query.lastError().text().contains("first"));
+
+		QVERIFY(!query.exec("SELECT * FROM missing_table"));
+		QVERIFY(query.lastError().isValid());
+
+		QVERIFY(query.exec("SELECT 1, 'text'"));
+		QVERIFY(!query.lastError().isValid());
+
+		// integers are accepted as floating point
+		QDuckDBTypedQuery<double> real(db.db());
+		QVERIFY(real.exec("SELECT 7"));
+		QCOMPARE(std::get<0>(real.rows()[0]), 7.0);
+	}
+};